@@ -3,18 +3,180 @@
 #include <string.h>
 #include <stdbool.h>
 #include <limits.h>
+#include <math.h>
+#include <stdarg.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <netinet/in.h>
+#include "sched_protocol.h"
+#include "sched_shm.h"
 
-#define MAX_EVENTS 1000
+#define MAX_EVENTS 5000
 #define MAX_TIME_SLOTS 48
+#define DAY_MINUTES (24 * 60)
 #define MAX_COLORS 20
-#define HASH_SIZE 997  // Prime number for hash table
+#define ID_INDEX_SHARDS 16            // Power of two; shard = id & (shards - 1)
+#define ID_INDEX_SHARD_CAPACITY 8192  // Power of two >= MAX_EVENTS, so no shard can fill
+#define MAX_ROOMS 32
+#define MAX_TASK_WORKERS 64
+#define TASK_DEQUE_CAPACITY 1024         // Power of two; a full deque runs work inline
+#define PARALLEL_PLACEMENT_THRESHOLD 64  // Smaller backlogs are placed serially
+#define PARALLEL_GRAPH_THRESHOLD 512     // Smaller graphs are built and colored serially
+#define MAX_SNAPSHOT_READERS 128
+#define MAX_MUTATION_BATCH 256
 
-// Hash table node for O(1) event lookup
-typedef struct HashNode {
-    int event_id;
-    int event_index;
-    struct HashNode* next;
-} HashNode;
+// Every heap allocation is counted, so the regression gate (--gate) can
+// report allocations per phase and per operation. On glibc the program
+// defines malloc, calloc, realloc and free itself and forwards them to the
+// C library's allocator. That interposes the calls libc makes internally
+// (stdio buffers, qsort scratch, time zone loading) as well as this
+// file's. Sanitizer builds keep their own allocator, and other C libraries
+// fall back to counting only the calls made from this file. Only --gate
+// turns counting on, so normal runs skip the shared atomic on every call.
+atomic_llong heap_allocations;
+bool heap_counting;            // Set once by --gate before any thread starts
+
+static inline void count_heap_allocation(void) {
+    if (heap_counting) atomic_fetch_add_explicit(&heap_allocations, 1, memory_order_relaxed);
+}
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define SCHED_SANITIZED_ALLOCATOR
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__)
+#define SCHED_SANITIZED_ALLOCATOR
+#endif
+
+#if defined(__GLIBC__) && !defined(SCHED_SANITIZED_ALLOCATOR)
+#define HEAP_COUNT_INTERPOSED 1
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* pointer, size_t size);
+extern void __libc_free(void* pointer);
+
+void* malloc(size_t size) {
+    count_heap_allocation();
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    count_heap_allocation();
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) {
+    count_heap_allocation();
+    return __libc_realloc(pointer, size);
+}
+
+void free(void* pointer) {
+    __libc_free(pointer);
+}
+#else
+#define HEAP_COUNT_INTERPOSED 0
+
+void* counted_malloc(size_t size) {
+    count_heap_allocation();
+    return malloc(size);
+}
+
+void* counted_calloc(size_t count, size_t size) {
+    count_heap_allocation();
+    return calloc(count, size);
+}
+
+void* counted_realloc(void* pointer, size_t size) {
+    count_heap_allocation();
+    return realloc(pointer, size);
+}
+
+#define malloc(size) counted_malloc(size)
+#define calloc(count, size) counted_calloc(count, size)
+#define realloc(pointer, size) counted_realloc(pointer, size)
+#endif
+
+// Strategy used by dynamic_reschedule() to pick which events get scheduled
+typedef enum {
+    STRATEGY_PRIORITY_GREEDY,    // Highest priority first (default)
+    STRATEGY_EARLIEST_FINISH,    // Earliest finish time, maximises event count
+    STRATEGY_EARLIEST_FINISH_K   // Earliest finish time across k parallel rooms
+} SchedulingStrategy;
+
+// Algorithm choices for the graph phases; AUTO lets the cost model decide
+typedef enum {
+    GRAPH_BUILD_AUTO,
+    GRAPH_BUILD_NAIVE,     // Compare every pair, O(n²)
+    GRAPH_BUILD_SWEEP      // Sweep line over start times, O(n log n + E)
+} GraphBuildAlgorithm;
+
+typedef enum {
+    COLORING_AUTO,
+    COLORING_WELSH_POWELL,
+    COLORING_INTERVAL_PARTITION,
+    COLORING_DSATUR
+} ColoringAlgorithm;
+
+typedef enum {
+    GRAPH_MODE_AUTO,
+    GRAPH_MODE_EAGER,      // Rebuild right after every edit
+    GRAPH_MODE_LAZY        // Rebuild only when a phase needs the graph
+} GraphMode;
+
+// Outcome of a budgeted reschedule. Anything but COMPLETE means the
+// schedule is valid but some events were left unscheduled or unroomed.
+typedef enum {
+    RESCHEDULE_COMPLETE,
+    RESCHEDULE_DEADLINE_EXCEEDED,
+    RESCHEDULE_CANCELLED
+} RescheduleStatus;
+
+// Set from any thread to stop a reschedule at its next check
+typedef struct {
+    atomic_bool cancelled;
+} CancelToken;
+
+// Cooperative limits checked inside the reschedule loops; NULL = unbounded
+typedef struct {
+    double deadline_ms;       // now_ms() value to stop at, 0 = no deadline
+    CancelToken* cancel;      // NULL = not cancellable
+    RescheduleStatus status;  // Set when a check fails
+    int checks;
+} RescheduleBudget;
+
+// Room feature flags (bitmask) matched against event requirements
+#define FEATURE_PROJECTOR    0x1
+#define FEATURE_LAB_BENCHES  0x2
+#define FEATURE_VIDEO_CONF   0x4
+#define FEATURE_WHITEBOARD   0x8
+
+// Open-addressing slot of the id index; key 0 marks an empty slot
+typedef struct {
+    atomic_int key;    // Event id
+    atomic_int value;  // Position of the event in events[]
+} IdIndexSlot;
+
+// One shard of the id -> index map. Readers take no lock: they retry when
+// seq is odd or changes under them. Writers serialise on write_lock.
+typedef struct {
+    atomic_uint seq;
+    atomic_flag write_lock;
+    int count;
+    IdIndexSlot slots[ID_INDEX_SHARD_CAPACITY];
+} IdIndexShard;
 
 // Time slot structure
 typedef struct {
@@ -31,11 +193,24 @@ typedef struct {
     TimeSlot time;
     int duration_minutes;
     int color;
+    int track;   // Parallel track from the k-room earliest finish strategy, -1 if none
     bool scheduled;
     int priority;
     int degree;  // Precomputed degree for sorting
+    int attendees;                  // Expected headcount, 0 = any room fits
+    unsigned int required_features; // FEATURE_* flags the room must offer
+    int room;                       // Index into rooms[], -1 if unassigned
+    int notify_set;                 // Index into notify_sets[], -1 if no timers are armed
 } Event;
 
+// Physical room that scheduled events are assigned to
+typedef struct {
+    int id;
+    char name[50];
+    int capacity;
+    unsigned int features;
+} Room;
+
 // Optimized graph node using adjacency list only
 typedef struct AdjListNode {
     int event_index;
@@ -46,516 +221,7820 @@ typedef struct AdjListNode {
 typedef struct {
     AdjListNode* adjacency_list[MAX_EVENTS];
     int num_events;
-    HashNode* event_hash[HASH_SIZE];  // Hash table for O(1) event lookup
 } ConflictGraph;
 
 // Global variables
 Event events[MAX_EVENTS];
 ConflictGraph conflict_graph;
+IdIndexShard id_index[ID_INDEX_SHARDS];  // Event id -> index, lock-free lookups
 int num_events = 0;
-int next_event_id = 1;
+atomic_int next_event_id = 1;          // Atomic so pipeline clients can reserve ids at submit
+Room rooms[MAX_ROOMS];
+int num_rooms = 0;
+int next_room_id = 1;
 
-// Optimization: Hash function for O(1) event lookup
-unsigned int hash_function(int event_id) {
-    return event_id % HASH_SIZE;
+
+// Calendar settings
+SchedulingStrategy scheduling_strategy = STRATEGY_PRIORITY_GREEDY;
+int eft_room_count = 0;       // k for STRATEGY_EARLIEST_FINISH_K, 0 = one per room
+bool verbose_output = true;   // Progress messages, turned off by benchmarks
+int batch_depth = 0;          // While > 0, add/remove skip the rebuild
+bool batch_graph_changed = false;  // An add or remove inside the current batch
+
+int task_threads = 0;                      // Workers for parallel phases, 0 = one per CPU
+unsigned long long placement_seed = 0;     // 0 = earliest slot first, else rotated search
+double reschedule_budget_ms = 50;  // Latency budget for interactive edits, 0 = none
+
+void dynamic_reschedule();
+void publish_snapshot();
+RescheduleStatus reschedule_after_edit();
+void repair_room_assignment(RescheduleBudget* budget);
+void notify_release(Event* event);
+
+double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
 }
 
-// Add event to hash table for O(1) lookup
-void hash_insert(int event_id, int event_index) {
-    unsigned int hash_key = hash_function(event_id);
-    HashNode* new_node = (HashNode*)malloc(sizeof(HashNode));
-    new_node->event_id = event_id;
-    new_node->event_index = event_index;
-    new_node->next = conflict_graph.event_hash[hash_key];
-    conflict_graph.event_hash[hash_key] = new_node;
+void cancel_token_reset(CancelToken* token) {
+    atomic_store(&token->cancelled, false);
 }
 
-// Find event index by ID in O(1) time
-int find_event_index(int event_id) {
-    unsigned int hash_key = hash_function(event_id);
-    HashNode* current = conflict_graph.event_hash[hash_key];
+void cancel_token_cancel(CancelToken* token) {
+    atomic_store(&token->cancelled, true);
+}
+
+RescheduleBudget make_budget(double budget_ms, CancelToken* cancel) {
+    RescheduleBudget budget;
+    budget.deadline_ms = budget_ms > 0 ? now_ms() + budget_ms : 0;
+    budget.cancel = cancel;
+    budget.status = RESCHEDULE_COMPLETE;
+    budget.checks = 0;
+    return budget;
+}
+
+// Returns true once the budget is spent. The clock is read every 16 checks
+// so the inner loops stay cheap; cancellation is seen immediately.
+bool budget_exhausted(RescheduleBudget* budget) {
+    if (budget == NULL) return false;
+    if (budget->status != RESCHEDULE_COMPLETE) return true;
     
-    while (current != NULL) {
-        if (current->event_id == event_id) {
-            return current->event_index;
+    if (budget->cancel != NULL && atomic_load(&budget->cancel->cancelled)) {
+        budget->status = RESCHEDULE_CANCELLED;
+        return true;
+    }
+    if (budget->deadline_ms > 0 && (budget->checks++ & 15) == 0 && now_ms() >= budget->deadline_ms) {
+        budget->status = RESCHEDULE_DEADLINE_EXCEEDED;
+        return true;
+    }
+    return false;
+}
+
+// Deadline/cancel test that does not touch the budget, for use inside
+// parallel tasks. The submitting thread records the outcome afterwards.
+bool budget_expired(const RescheduleBudget* budget) {
+    if (budget == NULL) return false;
+    if (budget->status != RESCHEDULE_COMPLETE) return true;
+    if (budget->cancel != NULL && atomic_load(&budget->cancel->cancelled)) return true;
+    return budget->deadline_ms > 0 && now_ms() >= budget->deadline_ms;
+}
+
+// Work-stealing task runtime. A phase calls parallel_for() with a body over
+// an index range; the range is split in half recursively, the upper halves
+// go on the caller's deque and idle workers steal the largest pieces from
+// the top, so uneven work spreads itself across cores.
+typedef void (*TaskBody)(void* arg, int begin, int end);
+
+typedef struct {
+    TaskBody body;
+    void* arg;
+    int grain;            // Pieces at most this large are not split further
+    atomic_int pending;   // Pieces spawned but not finished
+} TaskLoop;
+
+typedef struct {
+    TaskLoop* loop;
+    int begin;
+    int end;
+} Task;
+
+// Chase-Lev deque: the owner pushes and takes at bottom, thieves steal at
+// top. Only a steal racing the owner for the last task needs a CAS.
+typedef struct {
+    _Alignas(64) atomic_llong top;
+    _Alignas(64) atomic_llong bottom;
+    Task tasks[TASK_DEQUE_CAPACITY];
+} TaskDeque;
+
+TaskDeque task_deques[MAX_TASK_WORKERS];  // Deque 0 belongs to the submitting thread
+pthread_t task_pool[MAX_TASK_WORKERS];
+int task_pool_size = 1;                   // Deques with an owner, including deque 0
+atomic_int task_region_workers;           // Workers taking part in the running region, 0 = none
+unsigned long long task_generation = 0;   // Bumped per region to wake sleeping workers
+bool task_runtime_running = true;
+pthread_mutex_t task_sleep_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t task_wake = PTHREAD_COND_INITIALIZER;
+pthread_mutex_t task_region_lock = PTHREAD_MUTEX_INITIALIZER;
+_Thread_local int task_worker_id = -1;    // Deque owned by this thread, -1 = none
+
+bool task_deque_push(TaskDeque* deque, Task task) {
+    long long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    if (bottom - top >= TASK_DEQUE_CAPACITY) return false;
+    
+    deque->tasks[bottom & (TASK_DEQUE_CAPACITY - 1)] = task;
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_release);
+    return true;
+}
+
+bool task_deque_take(TaskDeque* deque, Task* task) {
+    long long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+    
+    if (top > bottom) {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return false;
+    }
+    *task = deque->tasks[bottom & (TASK_DEQUE_CAPACITY - 1)];
+    if (top == bottom) {
+        // Last task: whoever moves top first gets it
+        bool won = atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                           memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+bool task_deque_steal(TaskDeque* deque, Task* task) {
+    long long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (top >= bottom) return false;
+    
+    *task = deque->tasks[top & (TASK_DEQUE_CAPACITY - 1)];
+    return atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                   memory_order_seq_cst, memory_order_relaxed);
+}
+
+// Own deque first (newest, cache-warm work), then the other participants
+// starting from a random victim
+bool task_find(int self, int workers, unsigned long long* seed, Task* task) {
+    if (task_deque_take(&task_deques[self], task)) return true;
+    
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 7;
+    *seed ^= *seed << 17;
+    int first = (int)(*seed % (unsigned long long)workers);
+    for (int k = 0; k < workers; k++) {
+        int victim = (first + k) % workers;
+        if (victim != self && task_deque_steal(&task_deques[victim], task)) return true;
+    }
+    return false;
+}
+
+// Split off upper halves for thieves, then run what is left here
+void task_loop_execute(TaskLoop* loop, int begin, int end) {
+    TaskDeque* own = &task_deques[task_worker_id];
+    while (end - begin > loop->grain) {
+        int mid = begin + (end - begin) / 2;
+        Task upper = {loop, mid, end};
+        atomic_fetch_add_explicit(&loop->pending, 1, memory_order_relaxed);
+        if (!task_deque_push(own, upper)) {
+            atomic_fetch_sub_explicit(&loop->pending, 1, memory_order_relaxed);
+            break;
         }
-        current = current->next;
+        end = mid;
     }
-    return -1;  // Not found
+    loop->body(loop->arg, begin, end);
+}
+
+void task_run(Task* task) {
+    TaskLoop* loop = task->loop;
+    task_loop_execute(loop, task->begin, task->end);
+    atomic_fetch_sub_explicit(&loop->pending, 1, memory_order_release);  // Last touch of loop
 }
 
-// Remove from hash table
-void hash_remove(int event_id) {
-    unsigned int hash_key = hash_function(event_id);
-    HashNode* current = conflict_graph.event_hash[hash_key];
-    HashNode* prev = NULL;
+void* task_worker_main(void* arg) {
+    int self = (int)(long)arg;
+    unsigned long long seed = 0x9E3779B97F4A7C15ULL * (unsigned long long)(self + 1);
+    unsigned long long seen = 0;
+    task_worker_id = self;
     
-    while (current != NULL) {
-        if (current->event_id == event_id) {
-            if (prev == NULL) {
-                conflict_graph.event_hash[hash_key] = current->next;
+    for (;;) {
+        pthread_mutex_lock(&task_sleep_lock);
+        while (task_runtime_running && task_generation == seen) {
+            pthread_cond_wait(&task_wake, &task_sleep_lock);
+        }
+        seen = task_generation;
+        bool running = task_runtime_running;
+        pthread_mutex_unlock(&task_sleep_lock);
+        if (!running) break;
+        
+        // Keep stealing until the region ends or does not include us
+        while (self < atomic_load_explicit(&task_region_workers, memory_order_acquire)) {
+            Task task;
+            if (task_find(self, atomic_load_explicit(&task_region_workers, memory_order_relaxed), &seed, &task)) {
+                task_run(&task);
             } else {
-                prev->next = current->next;
+                sched_yield();
             }
-            free(current);
-            return;
         }
-        prev = current;
-        current = current->next;
     }
+    return NULL;
 }
 
-// Initialize optimized graph
-void initialize_graph() {
-    conflict_graph.num_events = 0;
-    for (int i = 0; i < MAX_EVENTS; i++) {
-        conflict_graph.adjacency_list[i] = NULL;
+void task_runtime_stop() {
+    pthread_mutex_lock(&task_sleep_lock);
+    task_runtime_running = false;
+    pthread_cond_broadcast(&task_wake);
+    pthread_mutex_unlock(&task_sleep_lock);
+    
+    for (int w = 1; w < task_pool_size; w++) {
+        pthread_join(task_pool[w], NULL);
     }
-    for (int i = 0; i < HASH_SIZE; i++) {
-        conflict_graph.event_hash[i] = NULL;
+    task_pool_size = 1;
+}
+
+// Workers are started on first use and kept for the life of the process
+void task_runtime_grow(int workers) {
+    if (task_pool_size == 1 && workers > 1) atexit(task_runtime_stop);
+    while (task_pool_size < workers) {
+        pthread_create(&task_pool[task_pool_size], NULL, task_worker_main, (void*)(long)task_pool_size);
+        task_pool_size++;
     }
 }
 
-// Optimized time conflict check (same logic, better naming)
-bool check_time_conflict(TimeSlot t1, TimeSlot t2) {
-    int t1_start = t1.start_hour * 60 + t1.start_minute;
-    int t1_end = t1.end_hour * 60 + t1.end_minute;
-    int t2_start = t2.start_hour * 60 + t2.start_minute;
-    int t2_end = t2.end_hour * 60 + t2.end_minute;
-    
-    return !(t1_end <= t2_start || t2_end <= t1_start);
+int task_worker_count() {
+    int workers = task_threads > 0 ? task_threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers < 1) workers = 1;
+    if (workers > MAX_TASK_WORKERS) workers = MAX_TASK_WORKERS;
+    return workers;
 }
 
-// Merge sort for O(n log n) sorting instead of O(n²) bubble sort
-void merge_events_by_degree(Event arr[], int left, int mid, int right) {
-    int i, j, k;
-    int n1 = mid - left + 1;
-    int n2 = right - mid;
+// Run body over [begin, end) on up to `workers` threads and return when
+// every piece has finished. The caller works too, and keeps stealing while
+// it waits. Nested calls from inside a task reuse the running region.
+void parallel_for(int begin, int end, int grain, int workers, TaskBody body, void* arg) {
+    if (end <= begin) return;
+    if (grain < 1) grain = 1;
+    
+    bool nested = task_worker_id >= 0;
+    if (!nested && (workers <= 1 || end - begin <= grain)) {
+        body(arg, begin, end);
+        return;
+    }
     
-    Event L[n1], R[n2];
+    if (!nested) {
+        pthread_mutex_lock(&task_region_lock);  // One region at a time from outside
+        if (workers > MAX_TASK_WORKERS) workers = MAX_TASK_WORKERS;
+        task_runtime_grow(workers);
+        task_worker_id = 0;
+        
+        pthread_mutex_lock(&task_sleep_lock);
+        atomic_store_explicit(&task_region_workers, workers, memory_order_release);
+        task_generation++;
+        pthread_cond_broadcast(&task_wake);
+        pthread_mutex_unlock(&task_sleep_lock);
+    }
     
-    for (i = 0; i < n1; i++)
-        L[i] = arr[left + i];
-    for (j = 0; j < n2; j++)
-        R[j] = arr[mid + 1 + j];
+    int self = task_worker_id;
+    int participants = atomic_load_explicit(&task_region_workers, memory_order_relaxed);
+    unsigned long long seed = 0xD1B54A32D192ED03ULL * (unsigned long long)(self + 1) + (unsigned long long)begin;
+    TaskLoop loop;
+    loop.body = body;
+    loop.arg = arg;
+    loop.grain = grain;
+    atomic_init(&loop.pending, 1);
     
-    i = 0; j = 0; k = left;
-    while (i < n1 && j < n2) {
-        if (L[i].degree >= R[j].degree) {  // Descending order
-            arr[k] = L[i];
-            i++;
+    task_loop_execute(&loop, begin, end);
+    atomic_fetch_sub_explicit(&loop.pending, 1, memory_order_release);
+    while (atomic_load_explicit(&loop.pending, memory_order_acquire) > 0) {
+        Task task;
+        if (task_find(self, participants, &seed, &task)) {
+            task_run(&task);
         } else {
-            arr[k] = R[j];
-            j++;
+            sched_yield();
         }
-        k++;
     }
     
-    while (i < n1) {
-        arr[k] = L[i];
-        i++; k++;
-    }
-    while (j < n2) {
-        arr[k] = R[j];
-        j++; k++;
+    if (!nested) {
+        atomic_store_explicit(&task_region_workers, 0, memory_order_release);
+        task_worker_id = -1;
+        pthread_mutex_unlock(&task_region_lock);
     }
 }
 
-void merge_sort_by_degree(Event arr[], int left, int right) {
-    if (left < right) {
-        int mid = left + (right - left) / 2;
-        merge_sort_by_degree(arr, left, mid);
-        merge_sort_by_degree(arr, mid + 1, right);
-        merge_events_by_degree(arr, left, mid, right);
+// Ids are handed out sequentially, so id & (shards - 1) spreads them evenly
+// and id / shards is already a good probe start inside the shard.
+IdIndexShard* id_index_shard(int event_id) {
+    return &id_index[event_id & (ID_INDEX_SHARDS - 1)];
+}
+
+unsigned int id_index_home(int event_id) {
+    return (unsigned int)(event_id / ID_INDEX_SHARDS) & (ID_INDEX_SHARD_CAPACITY - 1);
+}
+
+// Writer side of the shard seqlock: seq is odd while slots are being changed
+void id_index_write_begin(IdIndexShard* shard) {
+    while (atomic_flag_test_and_set_explicit(&shard->write_lock, memory_order_acquire)) {
+        sched_yield();
     }
+    atomic_store_explicit(&shard->seq, atomic_load_explicit(&shard->seq, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
 }
 
-// Merge sort for priority scheduling
-void merge_events_by_priority(Event arr[], int left, int mid, int right) {
-    int i, j, k;
-    int n1 = mid - left + 1;
-    int n2 = right - mid;
-    
-    Event L[n1], R[n2];
-    
-    for (i = 0; i < n1; i++)
-        L[i] = arr[left + i];
-    for (j = 0; j < n2; j++)
-        R[j] = arr[mid + 1 + j];
+void id_index_write_end(IdIndexShard* shard) {
+    atomic_store_explicit(&shard->seq, atomic_load_explicit(&shard->seq, memory_order_relaxed) + 1,
+                          memory_order_release);
+    atomic_flag_clear_explicit(&shard->write_lock, memory_order_release);
+}
+
+// Find event index by ID without taking a lock; safe from any thread.
+// The probe is bounded so a torn read can never loop, and the seq check
+// throws away any result that raced with a writer.
+int find_event_index(int event_id) {
+    if (event_id <= 0) return -1;
+    IdIndexShard* shard = id_index_shard(event_id);
+    unsigned int home = id_index_home(event_id);
     
-    i = 0; j = 0; k = left;
-    while (i < n1 && j < n2) {
-        bool should_place_L = false;
+    for (;;) {
+        unsigned int seq = atomic_load_explicit(&shard->seq, memory_order_acquire);
+        if (seq & 1) {
+            sched_yield();
+            continue;
+        }
         
-        if (L[i].priority > R[j].priority) {
-            should_place_L = true;
-        } else if (L[i].priority == R[j].priority) {
-            int time1 = L[i].time.start_hour * 60 + L[i].time.start_minute;
-            int time2 = R[j].time.start_hour * 60 + R[j].time.start_minute;
-            if (time1 <= time2) {
-                should_place_L = true;
+        int result = -1;
+        unsigned int slot = home;
+        for (int probes = 0; probes < ID_INDEX_SHARD_CAPACITY; probes++) {
+            int key = atomic_load_explicit(&shard->slots[slot].key, memory_order_relaxed);
+            if (key == 0) break;
+            if (key == event_id) {
+                result = atomic_load_explicit(&shard->slots[slot].value, memory_order_relaxed);
+                break;
             }
+            slot = (slot + 1) & (ID_INDEX_SHARD_CAPACITY - 1);
         }
         
-        if (should_place_L) {
-            arr[k] = L[i];
-            i++;
-        } else {
-            arr[k] = R[j];
-            j++;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&shard->seq, memory_order_relaxed) == seq) return result;
+    }
+}
+
+// Insert an id, or move an existing one to a new index
+void id_index_insert(int event_id, int event_index) {
+    IdIndexShard* shard = id_index_shard(event_id);
+    unsigned int slot = id_index_home(event_id);
+    
+    id_index_write_begin(shard);
+    for (;;) {
+        int key = atomic_load_explicit(&shard->slots[slot].key, memory_order_relaxed);
+        if (key == 0 || key == event_id) break;
+        slot = (slot + 1) & (ID_INDEX_SHARD_CAPACITY - 1);
+    }
+    if (atomic_load_explicit(&shard->slots[slot].key, memory_order_relaxed) == 0) shard->count++;
+    atomic_store_explicit(&shard->slots[slot].value, event_index, memory_order_relaxed);
+    atomic_store_explicit(&shard->slots[slot].key, event_id, memory_order_relaxed);
+    id_index_write_end(shard);
+}
+
+// Remove with backward-shift deletion so probe chains never need tombstones
+void id_index_remove(int event_id) {
+    IdIndexShard* shard = id_index_shard(event_id);
+    unsigned int mask = ID_INDEX_SHARD_CAPACITY - 1;
+    unsigned int hole = id_index_home(event_id);
+    
+    id_index_write_begin(shard);
+    for (;;) {
+        int key = atomic_load_explicit(&shard->slots[hole].key, memory_order_relaxed);
+        if (key == 0) {
+            id_index_write_end(shard);
+            return;
         }
-        k++;
+        if (key == event_id) break;
+        hole = (hole + 1) & mask;
     }
     
-    while (i < n1) {
-        arr[k] = L[i];
-        i++; k++;
+    unsigned int next = hole;
+    for (;;) {
+        next = (next + 1) & mask;
+        int key = atomic_load_explicit(&shard->slots[next].key, memory_order_relaxed);
+        if (key == 0) break;
+        
+        // The entry may fill the hole unless its home lies cyclically in (hole, next]
+        unsigned int home = id_index_home(key);
+        bool stays = hole < next ? (home > hole && home <= next) : (home > hole || home <= next);
+        if (!stays) {
+            atomic_store_explicit(&shard->slots[hole].value,
+                                  atomic_load_explicit(&shard->slots[next].value, memory_order_relaxed),
+                                  memory_order_relaxed);
+            atomic_store_explicit(&shard->slots[hole].key, key, memory_order_relaxed);
+            hole = next;
+        }
     }
-    while (j < n2) {
-        arr[k] = R[j];
-        j++; k++;
+    atomic_store_explicit(&shard->slots[hole].key, 0, memory_order_relaxed);
+    shard->count--;
+    id_index_write_end(shard);
+}
+
+void id_index_clear() {
+    for (int s = 0; s < ID_INDEX_SHARDS; s++) {
+        IdIndexShard* shard = &id_index[s];
+        if (shard->count == 0) continue;
+        
+        id_index_write_begin(shard);
+        for (int i = 0; i < ID_INDEX_SHARD_CAPACITY; i++) {
+            atomic_store_explicit(&shard->slots[i].key, 0, memory_order_relaxed);
+        }
+        shard->count = 0;
+        id_index_write_end(shard);
     }
 }
 
-void merge_sort_by_priority(Event arr[], int left, int right) {
-    if (left < right) {
-        int mid = left + (right - left) / 2;
-        merge_sort_by_priority(arr, left, mid);
-        merge_sort_by_priority(arr, mid + 1, right);
-        merge_events_by_priority(arr, left, mid, right);
+// Initialize optimized graph
+void initialize_graph() {
+    conflict_graph.num_events = 0;
+    for (int i = 0; i < MAX_EVENTS; i++) {
+        conflict_graph.adjacency_list[i] = NULL;
     }
 }
 
-// Optimized graph building - precompute degrees
-void build_conflict_graph() {
-    initialize_graph();
-    conflict_graph.num_events = num_events;
+// Optimized time conflict check (same logic, better naming)
+bool check_time_conflict(TimeSlot t1, TimeSlot t2) {
+    int t1_start = t1.start_hour * 60 + t1.start_minute;
+    int t1_end = t1.end_hour * 60 + t1.end_minute;
+    int t2_start = t2.start_hour * 60 + t2.start_minute;
+    int t2_end = t2.end_hour * 60 + t2.end_minute;
     
-    // Initialize degrees to 0
-    for (int i = 0; i < num_events; i++) {
-        events[i].degree = 0;
-    }
+    return !(t1_end <= t2_start || t2_end <= t1_start);
+}
+
+int event_start_minutes(const Event* event) {
+    return event->time.start_hour * 60 + event->time.start_minute;
+}
+
+int event_end_minutes(const Event* event) {
+    return event->time.end_hour * 60 + event->time.end_minute;
+}
+
+// Stable bottom-up merge sort of (key, index) pairs. Runs of SORT_RUN are
+// insertion sorted, then each pass merges neighbouring runs from one buffer
+// into the other. Every pass is cut into fixed-size output chunks whose
+// input split is found by binary search, so even the final merge of two
+// halves spreads across workers. The caller passes a scratch buffer as
+// long as the keys, so concurrent sorts never share state.
+#define SORT_RUN 32                      // Runs this short are insertion sorted
+#define SORT_MERGE_CHUNK 2048            // Output elements per merge task
+#define PARALLEL_SORT_THRESHOLD 2048     // Smaller arrays sort on the calling thread
+
+typedef struct {
+    long long key;
+    int index;
+} SortKey;
+
+// Buffers of the event sort helpers below. Like events[], they belong to
+// the thread that owns the event store.
+SortKey event_sort_keys[MAX_EVENTS];
+SortKey event_sort_scratch[MAX_EVENTS];
+
+typedef struct {
+    SortKey* src;
+    SortKey* dst;
+    int n;
+    int width;              // Length of the sorted runs being merged
+    int chunks_per_pair;
+} SortPass;
+
+void insertion_sort_runs_task(void* arg, int first, int last) {
+    SortPass* pass = (SortPass*)arg;
+    SortKey* keys = pass->src;
     
-    // Build adjacency list and count degrees in single pass
-    for (int i = 0; i < num_events; i++) {
-        for (int j = i + 1; j < num_events; j++) {
-            if (check_time_conflict(events[i].time, events[j].time)) {
-                // Add edge i -> j
-                AdjListNode* node1 = (AdjListNode*)malloc(sizeof(AdjListNode));
-                node1->event_index = j;
-                node1->next = conflict_graph.adjacency_list[i];
-                conflict_graph.adjacency_list[i] = node1;
-                
-                // Add edge j -> i
-                AdjListNode* node2 = (AdjListNode*)malloc(sizeof(AdjListNode));
-                node2->event_index = i;
-                node2->next = conflict_graph.adjacency_list[j];
-                conflict_graph.adjacency_list[j] = node2;
-                
-                // Increment degrees
-                events[i].degree++;
-                events[j].degree++;
+    for (int r = first; r < last; r++) {
+        int begin = r * SORT_RUN;
+        int end = begin + SORT_RUN < pass->n ? begin + SORT_RUN : pass->n;
+        for (int i = begin + 1; i < end; i++) {
+            SortKey item = keys[i];
+            int j = i - 1;
+            while (j >= begin && keys[j].key > item.key) {
+                keys[j + 1] = keys[j];
+                j--;
             }
+            keys[j + 1] = item;
         }
     }
 }
 
-// Optimized Welsh-Powell using merge sort O(n log n)
-void welsh_powell_coloring() {
-    if (num_events == 0) return;
-    
-    // Create temporary array for sorting
-    Event temp_events[MAX_EVENTS];
-    for (int i = 0; i < num_events; i++) {
-        temp_events[i] = events[i];
-    }
-    
-    // Sort by degree using merge sort - O(n log n)
-    merge_sort_by_degree(temp_events, 0, num_events - 1);
-    
-    // Initialize colors
-    for (int i = 0; i < num_events; i++) {
-        events[i].color = -1;
+// How many of the first k outputs of a stable merge of a and b come from a
+int merge_co_rank(const SortKey* a, int a_len, const SortKey* b, int b_len, int k) {
+    int lo = k > b_len ? k - b_len : 0;
+    int hi = k < a_len ? k : a_len;
+    while (lo < hi) {
+        int i = lo + (hi - lo) / 2;
+        if (b[k - i - 1].key >= a[i].key) {
+            lo = i + 1;
+        } else {
+            hi = i;
+        }
     }
+    return lo;
+}
+
+void merge_pass_task(void* arg, int first, int last) {
+    SortPass* pass = (SortPass*)arg;
     
-    // Color each event in sorted order
-    for (int i = 0; i < num_events; i++) {
-        int event_index = -1;
-        // Find the original index of this event
-        for (int j = 0; j < num_events; j++) {
-            if (events[j].id == temp_events[i].id) {
-                event_index = j;
-                break;
-            }
-        }
+    for (int t = first; t < last; t++) {
+        int base = (t / pass->chunks_per_pair) * 2 * pass->width;
+        int pair_end = base + 2 * pass->width < pass->n ? base + 2 * pass->width : pass->n;
+        int out_begin = base + (t % pass->chunks_per_pair) * SORT_MERGE_CHUNK;
+        if (out_begin >= pair_end) continue;
+        int out_end = out_begin + SORT_MERGE_CHUNK < pair_end ? out_begin + SORT_MERGE_CHUNK : pair_end;
+        int mid = base + pass->width < pass->n ? base + pass->width : pass->n;
         
-        if (event_index == -1) continue;
-        
-        int color = 0;
-        bool color_used[MAX_COLORS] = {false};
+        const SortKey* a = pass->src + base;
+        const SortKey* b = pass->src + mid;
+        int a_len = mid - base, b_len = pair_end - mid;
+        int i = merge_co_rank(a, a_len, b, b_len, out_begin - base);
+        int j = out_begin - base - i;
         
-        // Check colors of neighbors - O(degree)
-        AdjListNode* current = conflict_graph.adjacency_list[event_index];
-        while (current != NULL) {
-            if (events[current->event_index].color != -1) {
-                color_used[events[current->event_index].color] = true;
+        // Ties take from a, which keeps the sort stable
+        for (int k = out_begin; k < out_end; k++) {
+            if (j >= b_len || (i < a_len && a[i].key <= b[j].key)) {
+                pass->dst[k] = a[i++];
+            } else {
+                pass->dst[k] = b[j++];
             }
-            current = current->next;
-        }
-        
-        // Find first available color
-        while (color < MAX_COLORS && color_used[color]) {
-            color++;
         }
-        
-        events[event_index].color = color;
     }
 }
 
-// Optimized greedy scheduling using merge sort
-void greedy_interval_scheduling() {
-    if (num_events == 0) return;
+void sort_keys(SortKey keys[], SortKey scratch[], int n) {
+    if (n < 2) return;
     
-    // Sort by priority and start time using merge sort - O(n log n)
-    merge_sort_by_priority(events, 0, num_events - 1);
+    int workers = n >= PARALLEL_SORT_THRESHOLD ? task_worker_count() : 1;
+    SortPass pass;
+    pass.src = keys;
+    pass.dst = scratch;
+    pass.n = n;
     
-    // Mark all as unscheduled
-    for (int i = 0; i < num_events; i++) {
-        events[i].scheduled = false;
+    parallel_for(0, (n + SORT_RUN - 1) / SORT_RUN, 8, workers, insertion_sort_runs_task, &pass);
+    
+    for (int width = SORT_RUN; width < n; width *= 2) {
+        int pairs = (n + 2 * width - 1) / (2 * width);
+        pass.width = width;
+        pass.chunks_per_pair = (2 * width + SORT_MERGE_CHUNK - 1) / SORT_MERGE_CHUNK;
+        int grain = SORT_MERGE_CHUNK / (2 * width);
+        parallel_for(0, pairs * pass.chunks_per_pair, grain, workers, merge_pass_task, &pass);
+        
+        SortKey* swap = pass.src;
+        pass.src = pass.dst;
+        pass.dst = swap;
+    }
+    if (pass.src != keys) {
+        memcpy(keys, pass.src, (size_t)n * sizeof(SortKey));
     }
+}
+
+// Sort keys for the event orders the scheduler needs
+long long priority_sort_key(const Event* event) {
+    // Highest priority first, then earliest start
+    return -(long long)event->priority * 4294967296LL + event_start_minutes(event);
+}
+
+long long finish_sort_key(const Event* event) {
+    // Earliest finish first, ties broken by earlier start
+    return (long long)event_end_minutes(event) * 4294967296LL + event_start_minutes(event);
+}
+
+// Stable in-place reorder of events[] by key. The events move once, after
+// the keys are sorted; callers then run reindex_after_sort().
+void sort_events_by(long long (*key)(const Event*)) {
+    static Event reordered[MAX_EVENTS];
     
-    // Schedule greedily - O(n²) in worst case but better in practice
     for (int i = 0; i < num_events; i++) {
-        bool can_schedule = true;
-        
-        // Check conflicts only with already scheduled events
-        for (int j = 0; j < i; j++) {
-            if (events[j].scheduled && 
-                check_time_conflict(events[i].time, events[j].time)) {
-                can_schedule = false;
-                break;
-            }
+        event_sort_keys[i].key = key(&events[i]);
+        event_sort_keys[i].index = i;
+    }
+    sort_keys(event_sort_keys, event_sort_scratch, num_events);
+    for (int i = 0; i < num_events; i++) {
+        reordered[i] = events[event_sort_keys[i].index];
+    }
+    memcpy(events, reordered, (size_t)num_events * sizeof(Event));
+}
+
+// Stable sort of event indices by start time, used by the sweep-line passes
+void sort_indices_by_start(int order[], int count) {
+    for (int k = 0; k < count; k++) {
+        event_sort_keys[k].key = event_start_minutes(&events[order[k]]);
+        event_sort_keys[k].index = order[k];
+    }
+    sort_keys(event_sort_keys, event_sort_scratch, count);
+    for (int k = 0; k < count; k++) {
+        order[k] = event_sort_keys[k].index;
+    }
+}
+
+// Collect every event index ordered by start time
+void collect_all_by_start(int order[]) {
+    for (int i = 0; i < num_events; i++) {
+        order[i] = i;
+    }
+    sort_indices_by_start(order, num_events);
+}
+
+// Collect scheduled events ordered by start time, returns the count
+int collect_scheduled_by_start(int order[]) {
+    int count = 0;
+    for (int i = 0; i < num_events; i++) {
+        if (events[i].scheduled) {
+            order[count++] = i;
+        }
+    }
+    sort_indices_by_start(order, count);
+    return count;
+}
+
+// Adjacency nodes come from chunks that are recycled wholesale on every
+// rebuild. Each thread bumps through its own chunk, so parallel builds never
+// contend on malloc and a rebuild frees nothing node by node. Nodes dropped
+// by an in-place patch go on the patching thread's free list and are
+// handed out again first, so a run of updates does not grow the pool.
+// After each build the pool keeps 25% spare chunks, so the edges that
+// edits add before the next rebuild never reach malloc.
+#define ADJ_CHUNK_NODES 16384
+
+typedef struct AdjChunk {
+    struct AdjChunk* next;
+    AdjListNode nodes[ADJ_CHUNK_NODES];
+} AdjChunk;
+
+AdjChunk* adj_chunks_used = NULL;
+AdjChunk* adj_chunks_free = NULL;
+int adj_chunks_used_count = 0;
+int adj_chunks_free_count = 0;
+pthread_mutex_t adj_chunk_lock = PTHREAD_MUTEX_INITIALIZER;
+atomic_uint adj_pool_generation;              // Bumped when all chunks are recycled
+_Thread_local AdjChunk* adj_cursor = NULL;    // This thread's current chunk
+_Thread_local int adj_cursor_used = 0;
+_Thread_local unsigned int adj_cursor_generation = 0;
+_Thread_local AdjListNode* adj_free_nodes = NULL;   // Valid only while adj_cursor_generation is current
+
+AdjListNode* adjacency_node_alloc() {
+    unsigned int generation = atomic_load_explicit(&adj_pool_generation, memory_order_relaxed);
+    if (adj_free_nodes != NULL && adj_cursor_generation == generation) {
+        AdjListNode* node = adj_free_nodes;
+        adj_free_nodes = node->next;
+        return node;
+    }
+    if (adj_cursor == NULL || adj_cursor_generation != generation || adj_cursor_used == ADJ_CHUNK_NODES) {
+        pthread_mutex_lock(&adj_chunk_lock);
+        AdjChunk* chunk = adj_chunks_free;
+        if (chunk != NULL) {
+            adj_chunks_free = chunk->next;
+            adj_chunks_free_count--;
+        } else {
+            chunk = (AdjChunk*)malloc(sizeof(AdjChunk));
         }
+        chunk->next = adj_chunks_used;
+        adj_chunks_used = chunk;
+        adj_chunks_used_count++;
+        pthread_mutex_unlock(&adj_chunk_lock);
         
-        events[i].scheduled = can_schedule;
+        adj_cursor = chunk;
+        adj_cursor_used = 0;
+        adj_cursor_generation = generation;
+        adj_free_nodes = NULL;
     }
+    return &adj_cursor->nodes[adj_cursor_used++];
 }
 
-// Add event with hash table optimization
-void add_event(char* name, int start_hour, int start_minute, int duration_minutes, int priority) {
-    if (num_events >= MAX_EVENTS) {
-        printf("Cannot add more events. Maximum capacity reached.\n");
-        return;
+void adjacency_node_free(AdjListNode* node) {
+    unsigned int generation = atomic_load_explicit(&adj_pool_generation, memory_order_relaxed);
+    if (adj_cursor_generation != generation) {
+        adj_cursor = NULL;              // Its chunk went back to the pool in the last rebuild
+        adj_cursor_generation = generation;
+        adj_free_nodes = NULL;
+    }
+    node->next = adj_free_nodes;
+    adj_free_nodes = node;
+}
+
+// Drop adjacency lists from the previous build; the id index is kept
+void clear_adjacency_lists() {
+    for (int i = 0; i < MAX_EVENTS; i++) {
+        conflict_graph.adjacency_list[i] = NULL;
     }
     
-    Event new_event;
-    new_event.id = next_event_id++;
+    pthread_mutex_lock(&adj_chunk_lock);
+    while (adj_chunks_used != NULL) {
+        AdjChunk* chunk = adj_chunks_used;
+        adj_chunks_used = chunk->next;
+        chunk->next = adj_chunks_free;
+        adj_chunks_free = chunk;
+    }
+    adj_chunks_free_count += adj_chunks_used_count;
+    adj_chunks_used_count = 0;
+    atomic_fetch_add_explicit(&adj_pool_generation, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&adj_chunk_lock);
+}
+
+// Top the free list up to a quarter of the chunks in use (at least one)
+void adjacency_pool_reserve() {
+    pthread_mutex_lock(&adj_chunk_lock);
+    while (adj_chunks_free_count < adj_chunks_used_count / 4 + 1) {
+        AdjChunk* chunk = (AdjChunk*)malloc(sizeof(AdjChunk));
+        chunk->next = adj_chunks_free;
+        adj_chunks_free = chunk;
+        adj_chunks_free_count++;
+    }
+    pthread_mutex_unlock(&adj_chunk_lock);
+}
+
+// Work done by the graph builders. It depends only on the events and the
+// algorithms chosen, so --gate checks it exactly.
+atomic_llong edges_built;
+atomic_llong overlap_tests;     // Interval pairs compared
+
+// Add an undirected conflict edge and bump both degrees
+void add_conflict_edge(int i, int j) {
+    AdjListNode* node1 = adjacency_node_alloc();
+    node1->event_index = j;
+    node1->next = conflict_graph.adjacency_list[i];
+    conflict_graph.adjacency_list[i] = node1;
+    
+    AdjListNode* node2 = adjacency_node_alloc();
+    node2->event_index = i;
+    node2->next = conflict_graph.adjacency_list[j];
+    conflict_graph.adjacency_list[j] = node2;
+    
+    events[i].degree++;
+    events[j].degree++;
+}
+
+// Drop every edge of one event and its neighbours' back edges, returning
+// the nodes to the free list
+void detach_conflict_edges(int i) {
+    AdjListNode* current = conflict_graph.adjacency_list[i];
+    while (current != NULL) {
+        int j = current->event_index;
+        AdjListNode** link = &conflict_graph.adjacency_list[j];
+        while (*link != NULL && (*link)->event_index != i) {
+            link = &(*link)->next;
+        }
+        if (*link != NULL) {
+            AdjListNode* back = *link;
+            *link = back->next;
+            adjacency_node_free(back);
+        }
+        events[j].degree--;
+        AdjListNode* next = current->next;
+        adjacency_node_free(current);
+        current = next;
+    }
+    conflict_graph.adjacency_list[i] = NULL;
+    events[i].degree = 0;
+}
+
+// Connect one event to everything its current time overlaps, O(n)
+void attach_conflict_edges(int i) {
+    long long edges = 0;
+    for (int j = 0; j < num_events; j++) {
+        if (j != i && check_time_conflict(events[i].time, events[j].time)) {
+            add_conflict_edge(i, j);
+            edges++;
+        }
+    }
+    atomic_fetch_add_explicit(&edges_built, edges, memory_order_relaxed);
+    atomic_fetch_add_explicit(&overlap_tests, num_events > 0 ? num_events - 1 : 0, memory_order_relaxed);
+}
+
+void reset_conflict_graph() {
+    clear_adjacency_lists();
+    conflict_graph.num_events = num_events;
+    for (int i = 0; i < num_events; i++) {
+        events[i].degree = 0;
+    }
+}
+
+// Naive graph building: test every pair, O(n²)
+void build_conflict_graph_naive(RescheduleBudget* budget) {
+    long long edges = 0, tests = 0;
+    reset_conflict_graph();
+    
+    for (int i = 0; i < num_events && !budget_exhausted(budget); i++) {
+        tests += num_events - i - 1;
+        for (int j = i + 1; j < num_events; j++) {
+            if (check_time_conflict(events[i].time, events[j].time)) {
+                add_conflict_edge(i, j);
+                edges++;
+            }
+        }
+    }
+    atomic_fetch_add_explicit(&edges_built, edges, memory_order_relaxed);
+    atomic_fetch_add_explicit(&overlap_tests, tests, memory_order_relaxed);
+}
+
+// Connected components of an interval graph are runs of the start-sorted
+// order: a new one begins when an event starts after every earlier end.
+// Nothing conflicts across components, so each can be built and colored
+// by its own task without locks.
+typedef struct {
+    int order[MAX_EVENTS];                // Event indices sorted by start
+    int start[MAX_EVENTS];                // Start/end minutes in that order
+    int end[MAX_EVENTS];
+    int component_start[MAX_EVENTS + 1];  // Component c is order[component_start[c]..component_start[c + 1])
+    int num_components;
+} ComponentLayout;
+
+ComponentLayout component_layout;
+
+void build_component_layout(ComponentLayout* layout) {
+    int reach = INT_MIN;
+    
+    collect_all_by_start(layout->order);
+    layout->num_components = 0;
+    for (int k = 0; k < num_events; k++) {
+        layout->start[k] = event_start_minutes(&events[layout->order[k]]);
+        layout->end[k] = event_end_minutes(&events[layout->order[k]]);
+        if (layout->start[k] >= reach) layout->component_start[layout->num_components++] = k;
+        if (layout->end[k] > reach) reach = layout->end[k];
+    }
+    layout->component_start[layout->num_components] = num_events;
+}
+
+typedef struct {
+    ComponentLayout* layout;
+    const RescheduleBudget* budget;
+    atomic_bool stopped;      // Set by the first task to see the budget run out
+} ComponentJob;
+
+bool component_job_stopped(ComponentJob* job) {
+    if (atomic_load_explicit(&job->stopped, memory_order_relaxed)) return true;
+    if (budget_expired(job->budget)) {
+        atomic_store_explicit(&job->stopped, true, memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+// Run body over every component, in parallel once the graph is big enough.
+// Tasks only read the budget; its status is recorded here afterwards.
+void run_component_phase(ComponentLayout* layout, RescheduleBudget* budget, TaskBody body) {
+    ComponentJob job;
+    job.layout = layout;
+    job.budget = budget;
+    atomic_init(&job.stopped, false);
+    
+    int workers = num_events >= PARALLEL_GRAPH_THRESHOLD ? task_worker_count() : 1;
+    int grain = layout->num_components / (workers * 8);
+    parallel_for(0, layout->num_components, grain, workers, body, &job);
+    
+    if (atomic_load(&job.stopped) && budget != NULL && budget->status == RESCHEDULE_COMPLETE) {
+        bool cancelled = budget->cancel != NULL && atomic_load(&budget->cancel->cancelled);
+        budget->status = cancelled ? RESCHEDULE_CANCELLED : RESCHEDULE_DEADLINE_EXCEEDED;
+    }
+}
+
+// Sweep within each component: compare only against later events that
+// start before this one ends. Same overlap test as check_time_conflict().
+void sweep_build_task(void* arg, int first, int last) {
+    ComponentJob* job = (ComponentJob*)arg;
+    ComponentLayout* layout = job->layout;
+    long long edges = 0, tests = 0;
+    
+    for (int c = first; c < last && !component_job_stopped(job); c++) {
+        int stop = layout->component_start[c + 1];
+        for (int a = layout->component_start[c]; a < stop; a++) {
+            if ((a & 63) == 63 && component_job_stopped(job)) break;
+            for (int b = a + 1; b < stop && layout->start[b] < layout->end[a]; b++) {
+                tests++;
+                if (layout->end[b] > layout->start[a]) {
+                    add_conflict_edge(layout->order[a], layout->order[b]);
+                    edges++;
+                }
+            }
+        }
+    }
+    atomic_fetch_add_explicit(&edges_built, edges, memory_order_relaxed);
+    atomic_fetch_add_explicit(&overlap_tests, tests, memory_order_relaxed);
+}
+
+// Sweep-line graph building, O(n log n + E), one task per component
+void build_conflict_graph_sweep(RescheduleBudget* budget) {
+    reset_conflict_graph();
+    build_component_layout(&component_layout);
+    run_component_phase(&component_layout, budget, sweep_build_task);
+}
+
+// Welsh-Powell: color vertices in descending degree order, O(n log n + E)
+void welsh_powell_coloring(RescheduleBudget* budget) {
+    if (num_events == 0) return;
+    
+    // Highest degree first; the sort is stable, so ties keep index order
+    for (int i = 0; i < num_events; i++) {
+        event_sort_keys[i].key = -(long long)events[i].degree;
+        event_sort_keys[i].index = i;
+        events[i].color = -1;
+    }
+    sort_keys(event_sort_keys, event_sort_scratch, num_events);
+    
+    // Color each event in sorted order; a stop leaves the rest at -1
+    for (int k = 0; k < num_events && !budget_exhausted(budget); k++) {
+        int event_index = event_sort_keys[k].index;
+        int color = 0;
+        bool color_used[MAX_COLORS] = {false};
+        
+        // Check colors of neighbors - O(degree)
+        AdjListNode* current = conflict_graph.adjacency_list[event_index];
+        while (current != NULL) {
+            if (events[current->event_index].color >= 0 && events[current->event_index].color < MAX_COLORS) {
+                color_used[events[current->event_index].color] = true;
+            }
+            current = current->next;
+        }
+        
+        // Find first available color
+        while (color < MAX_COLORS && color_used[color]) {
+            color++;
+        }
+        
+        events[event_index].color = color < MAX_COLORS ? color : -1;
+    }
+}
+
+// Binary min-heap of (key, value) pairs shared by the sweep passes
+typedef struct {
+    int key;
+    int value;
+} HeapEntry;
+
+void heap_push(HeapEntry heap[], int* size, int key, int value) {
+    int i = (*size)++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (heap[parent].key <= key) break;
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i].key = key;
+    heap[i].value = value;
+}
+
+HeapEntry heap_pop(HeapEntry heap[], int* size) {
+    HeapEntry top = heap[0];
+    HeapEntry last = heap[--(*size)];
+    int i = 0;
+    while (true) {
+        int child = 2 * i + 1;
+        if (child >= *size) break;
+        if (child + 1 < *size && heap[child + 1].key < heap[child].key) child++;
+        if (last.key <= heap[child].key) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (*size > 0) heap[i] = last;
+    return top;
+}
+
+// Interval partitioning: sweep by start time and reuse the lowest color
+// whose last event has ended. Optimal for interval graphs, O(n log n).
+// Every color is free again at a component boundary, so running each
+// component from color 0 gives exactly the single-sweep result.
+HeapEntry partition_active[MAX_EVENTS];  // (end time, color) of running events
+HeapEntry partition_free[MAX_EVENTS];    // (color, color) ready for reuse
+
+void interval_partition_task(void* arg, int first, int last) {
+    ComponentJob* job = (ComponentJob*)arg;
+    ComponentLayout* layout = job->layout;
+    
+    for (int c = first; c < last && !component_job_stopped(job); c++) {
+        // A component of m events never needs more than m heap entries
+        int base = layout->component_start[c];
+        HeapEntry* active = partition_active + base;
+        HeapEntry* free_colors = partition_free + base;
+        int active_size = 0, free_size = 0, colors_opened = 0;
+        
+        for (int k = base; k < layout->component_start[c + 1]; k++) {
+            if ((k & 63) == 63 && component_job_stopped(job)) return;
+            
+            while (active_size > 0 && active[0].key <= layout->start[k]) {
+                HeapEntry done = heap_pop(active, &active_size);
+                heap_push(free_colors, &free_size, done.value, done.value);
+            }
+            
+            int color = free_size > 0 ? heap_pop(free_colors, &free_size).value : colors_opened++;
+            heap_push(active, &active_size, layout->end[k], color);
+            events[layout->order[k]].color = color < MAX_COLORS ? color : -1;
+        }
+    }
+}
+
+void interval_partition_coloring(RescheduleBudget* budget) {
+    for (int i = 0; i < num_events; i++) {
+        events[i].color = -1;
+    }
+    build_component_layout(&component_layout);
+    run_component_phase(&component_layout, budget, interval_partition_task);
+}
+
+// DSatur: repeatedly color the vertex seeing the most distinct neighbor
+// colors (ties by degree, then lowest index). Neighbor colors fit in a
+// bitmask. Vertices only ever compete with their own component, so each
+// component runs separately in O(m² + E) and the coloring matches a
+// whole-graph run.
+unsigned int dsatur_neighbor_colors[MAX_EVENTS];
+bool dsatur_colored[MAX_EVENTS];
+
+void dsatur_task(void* arg, int first, int last) {
+    ComponentJob* job = (ComponentJob*)arg;
+    ComponentLayout* layout = job->layout;
+    
+    for (int c = first; c < last && !component_job_stopped(job); c++) {
+        int begin = layout->component_start[c];
+        int stop = layout->component_start[c + 1];
+        
+        for (int step = begin; step < stop; step++) {
+            if ((step & 63) == 63 && component_job_stopped(job)) return;
+            
+            int best = -1, best_saturation = -1;
+            for (int k = begin; k < stop; k++) {
+                int i = layout->order[k];
+                if (dsatur_colored[i]) continue;
+                int saturation = __builtin_popcount(dsatur_neighbor_colors[i]);
+                if (saturation > best_saturation ||
+                    (saturation == best_saturation &&
+                     (events[i].degree > events[best].degree ||
+                      (events[i].degree == events[best].degree && i < best)))) {
+                    best = i;
+                    best_saturation = saturation;
+                }
+            }
+            
+            int color = 0;
+            while (color < MAX_COLORS && (dsatur_neighbor_colors[best] & (1u << color))) {
+                color++;
+            }
+            dsatur_colored[best] = true;
+            if (color == MAX_COLORS) continue;  // Out of colors, leave at -1
+            
+            events[best].color = color;
+            AdjListNode* current = conflict_graph.adjacency_list[best];
+            while (current != NULL) {
+                dsatur_neighbor_colors[current->event_index] |= 1u << color;
+                current = current->next;
+            }
+        }
+    }
+}
+
+void dsatur_coloring(RescheduleBudget* budget) {
+    for (int i = 0; i < num_events; i++) {
+        events[i].color = -1;
+        dsatur_neighbor_colors[i] = 0;
+        dsatur_colored[i] = false;
+    }
+    build_component_layout(&component_layout);
+    run_component_phase(&component_layout, budget, dsatur_task);
+}
+
+// Cheap workload statistics that drive algorithm selection. One sweep over
+// start-sorted events with a heap of end times gives all of them in O(n log n).
+typedef struct {
+    int num_events;
+    long long num_edges;
+    double average_overlap;   // Average conflicts per event (2E / n)
+    int largest_component;    // Events in the biggest chain of overlaps
+    int max_overlap;          // Most events running at once = colors needed
+} ScheduleStats;
+
+// Cost model coefficients in microseconds: each phase costs
+// (work term * coefficient) + (edges * edge coefficient).
+// Defaults were measured with --calibrate; cost_model.txt overrides them.
+#define COST_MODEL_DEFAULTS {0.0043, 0.0071, 0.012, 0.0097, 0.0092, 0.016, 0.016, 0.0028, 0.0018}
+
+typedef struct {
+    double naive_build;         // per n²/2 pair test
+    double naive_build_edge;
+    double sweep_build;         // per n log n
+    double sweep_build_edge;
+    double welsh_powell;        // per n log n (degree sort)
+    double welsh_powell_edge;
+    double interval_partition;  // per n log n, never touches edges
+    double dsatur;              // per n * largest component (vertex selection)
+    double dsatur_edge;
+} CostModel;
+
+CostModel cost_model = COST_MODEL_DEFAULTS;
+ScheduleStats schedule_stats;
+GraphBuildAlgorithm forced_graph_build = GRAPH_BUILD_AUTO;
+ColoringAlgorithm forced_coloring = COLORING_AUTO;
+GraphMode forced_graph_mode = GRAPH_MODE_AUTO;
+bool graph_dirty = true;      // Events changed since the last graph build
+long long graph_edits = 0;    // Edits that invalidated the graph
+long long graph_uses = 0;     // Times a phase actually needed the graph
+
+void compute_schedule_stats(ScheduleStats* stats) {
+    static int order[MAX_EVENTS];
+    static HeapEntry active[MAX_EVENTS];
+    int active_size = 0;
+    int component_size = 0, component_end = INT_MIN;
+    
+    stats->num_events = num_events;
+    stats->num_edges = 0;
+    stats->largest_component = 0;
+    stats->max_overlap = 0;
+    
+    collect_all_by_start(order);
+    for (int k = 0; k < num_events; k++) {
+        Event* event = &events[order[k]];
+        int start = event_start_minutes(event);
+        int end = event_end_minutes(event);
+        
+        while (active_size > 0 && active[0].key <= start) {
+            heap_pop(active, &active_size);
+        }
+        stats->num_edges += active_size;
+        heap_push(active, &active_size, end, order[k]);
+        if (active_size > stats->max_overlap) stats->max_overlap = active_size;
+        
+        // A start past every earlier end begins a new connected component
+        if (start >= component_end) {
+            component_size = 0;
+            component_end = end;
+        }
+        component_size++;
+        if (end > component_end) component_end = end;
+        if (component_size > stats->largest_component) stats->largest_component = component_size;
+    }
+    
+    stats->average_overlap = num_events > 0 ? 2.0 * stats->num_edges / num_events : 0.0;
+}
+
+double n_log_n(int n) {
+    double log2n = 0;
+    for (int m = n; m > 1; m >>= 1) log2n++;
+    return n * (log2n > 0 ? log2n : 1);
+}
+
+double estimate_build_cost(GraphBuildAlgorithm algorithm, const ScheduleStats* stats) {
+    double n = stats->num_events;
+    double e = (double)stats->num_edges;
+    if (algorithm == GRAPH_BUILD_NAIVE) {
+        return cost_model.naive_build * n * n / 2 + cost_model.naive_build_edge * e;
+    }
+    return cost_model.sweep_build * n_log_n(stats->num_events) + cost_model.sweep_build_edge * e;
+}
+
+double estimate_coloring_cost(ColoringAlgorithm algorithm, const ScheduleStats* stats) {
+    double n = stats->num_events;
+    double e = (double)stats->num_edges;
+    switch (algorithm) {
+        case COLORING_INTERVAL_PARTITION:
+            return cost_model.interval_partition * n_log_n(stats->num_events);
+        case COLORING_DSATUR:
+            return cost_model.dsatur * n * stats->largest_component + cost_model.dsatur_edge * e;
+        default:
+            return cost_model.welsh_powell * n_log_n(stats->num_events) + cost_model.welsh_powell_edge * e;
+    }
+}
+
+GraphBuildAlgorithm choose_graph_build(const ScheduleStats* stats) {
+    if (forced_graph_build != GRAPH_BUILD_AUTO) return forced_graph_build;
+    return estimate_build_cost(GRAPH_BUILD_NAIVE, stats) <= estimate_build_cost(GRAPH_BUILD_SWEEP, stats)
+           ? GRAPH_BUILD_NAIVE : GRAPH_BUILD_SWEEP;
+}
+
+// Every coloring is valid; interval partitioning is also optimal for this
+// graph, so the others only win when the model says they are cheaper.
+ColoringAlgorithm choose_coloring(const ScheduleStats* stats) {
+    if (forced_coloring != COLORING_AUTO) return forced_coloring;
+    
+    ColoringAlgorithm best = COLORING_INTERVAL_PARTITION;
+    ColoringAlgorithm candidates[] = {COLORING_WELSH_POWELL, COLORING_DSATUR};
+    for (int c = 0; c < 2; c++) {
+        if (estimate_coloring_cost(candidates[c], stats) < estimate_coloring_cost(best, stats)) {
+            best = candidates[c];
+        }
+    }
+    return best;
+}
+
+// Eager builds after every edit; lazy waits until a phase needs the graph.
+// Lazy does strictly less work unless nearly every edit is followed by a use,
+// in which case eager keeps the build off the read path.
+GraphMode choose_graph_mode() {
+    if (forced_graph_mode != GRAPH_MODE_AUTO) return forced_graph_mode;
+    return graph_uses >= graph_edits ? GRAPH_MODE_EAGER : GRAPH_MODE_LAZY;
+}
+
+const char* graph_build_name(GraphBuildAlgorithm algorithm) {
+    switch (algorithm) {
+        case GRAPH_BUILD_AUTO: return "auto";
+        case GRAPH_BUILD_NAIVE: return "naive pairwise";
+        case GRAPH_BUILD_SWEEP: return "sweep line";
+    }
+    return "unknown";
+}
+
+const char* coloring_name(ColoringAlgorithm algorithm) {
+    switch (algorithm) {
+        case COLORING_AUTO: return "auto";
+        case COLORING_WELSH_POWELL: return "Welsh-Powell";
+        case COLORING_INTERVAL_PARTITION: return "interval partitioning";
+        case COLORING_DSATUR: return "DSatur";
+    }
+    return "unknown";
+}
+
+const char* graph_mode_name(GraphMode mode) {
+    switch (mode) {
+        case GRAPH_MODE_AUTO: return "auto";
+        case GRAPH_MODE_EAGER: return "eager";
+        case GRAPH_MODE_LAZY: return "lazy";
+    }
+    return "unknown";
+}
+
+// Build the conflict graph with whichever algorithm the cost model prefers.
+// A build cut short by the budget stays dirty and is redone on next use.
+void build_conflict_graph(RescheduleBudget* budget) {
+    compute_schedule_stats(&schedule_stats);
+    
+    if (choose_graph_build(&schedule_stats) == GRAPH_BUILD_NAIVE) {
+        build_conflict_graph_naive(budget);
+    } else {
+        build_conflict_graph_sweep(budget);
+    }
+    graph_dirty = budget_exhausted(budget);
+    adjacency_pool_reserve();
+}
+
+// Called after one event's interval changed in place: a built graph is
+// patched instead of rebuilt. Workload stats only track the edge count
+// until the next rebuild refreshes them.
+void conflict_graph_moved(int index) {
+    if (graph_dirty || batch_graph_changed || conflict_graph.num_events != num_events) return;  // Rebuilt later
+    
+    int old_degree = events[index].degree;
+    detach_conflict_edges(index);
+    attach_conflict_edges(index);
+    schedule_stats.num_edges += events[index].degree - old_degree;
+    schedule_stats.average_overlap = num_events > 0 ? 2.0 * schedule_stats.num_edges / num_events : 0.0;
+}
+
+// Called after events are added or removed
+void conflict_graph_changed() {
+    graph_dirty = true;
+    graph_edits++;
+    if (choose_graph_mode() == GRAPH_MODE_EAGER) {
+        build_conflict_graph(NULL);
+    }
+}
+
+// Called by every phase that reads adjacency lists or degrees
+void ensure_conflict_graph(RescheduleBudget* budget) {
+    graph_uses++;
+    if (graph_dirty || conflict_graph.num_events != num_events) {
+        build_conflict_graph(budget);
+    }
+}
+
+void color_conflict_graph(RescheduleBudget* budget) {
+    ensure_conflict_graph(budget);
+    if (budget_exhausted(budget)) return;
+    
+    switch (choose_coloring(&schedule_stats)) {
+        case COLORING_INTERVAL_PARTITION:
+            interval_partition_coloring(budget);
+            break;
+        case COLORING_DSATUR:
+            dsatur_coloring(budget);
+            break;
+        default:
+            welsh_powell_coloring(budget);
+            break;
+    }
+}
+
+
+// Sorting events[] in place leaves the id index and adjacency lists pointing
+// at the old positions. Remap both through the permutation in O(n + E).
+// The sweep build allocates an event's edge nodes while its neighbours are
+// being swept, so lists visited in start order touch nodes that lie close
+// together; in any other order the remap is a cache miss per edge.
+void reindex_after_sort() {
+    static int new_index_of[MAX_EVENTS];
+    static AdjListNode* old_lists[MAX_EVENTS];
+    static int by_start[MAX_EVENTS];
+    
+    for (int i = 0; i < num_events; i++) {
+        new_index_of[find_event_index(events[i].id)] = i;
+    }
+    
+    for (int i = 0; i < num_events; i++) {
+        id_index_insert(events[i].id, i);
+    }
+    
+    if (graph_dirty || conflict_graph.num_events != num_events) return;  // Rebuilt on next use
+    
+    for (int i = 0; i < num_events; i++) {
+        old_lists[i] = conflict_graph.adjacency_list[i];
+    }
+    for (int i = 0; i < num_events; i++) {
+        conflict_graph.adjacency_list[new_index_of[i]] = old_lists[i];
+    }
+    
+    collect_all_by_start(by_start);
+    for (int k = 0; k < num_events; k++) {
+        for (AdjListNode* current = conflict_graph.adjacency_list[by_start[k]]; current != NULL;
+             current = current->next) {
+            current->event_index = new_index_of[current->event_index];
+        }
+    }
+}
+
+// Minutes of the day covered by scheduled events, one bit per minute.
+// Candidate slots all lie inside the day, so events running past midnight
+// are clipped without changing any answer.
+#define DAY_WORDS ((DAY_MINUTES + 63) / 64)
+
+typedef struct {
+    unsigned long long bits[DAY_WORDS];
+} DayOccupancy;
+
+unsigned long long minute_mask(int word, int start, int end) {
+    int lo = start > word * 64 ? start - word * 64 : 0;
+    int hi = end < (word + 1) * 64 ? end - word * 64 : 64;
+    unsigned long long upper = hi == 64 ? ~0ULL : (1ULL << hi) - 1;
+    return upper & ~((1ULL << lo) - 1);
+}
+
+void occupancy_mark(DayOccupancy* day, int start, int end) {
+    if (start < 0) start = 0;
+    if (end > DAY_MINUTES) end = DAY_MINUTES;
+    for (int word = start / 64; start < end && word <= (end - 1) / 64; word++) {
+        day->bits[word] |= minute_mask(word, start, end);
+    }
+}
+
+bool occupancy_free(const DayOccupancy* day, int start, int end) {
+    if (start < 0) start = 0;
+    if (end > DAY_MINUTES) end = DAY_MINUTES;
+    for (int word = start / 64; start < end && word <= (end - 1) / 64; word++) {
+        if (day->bits[word] & minute_mask(word, start, end)) return false;
+    }
+    return true;
+}
+
+// Occupancy of everything scheduled. False if some scheduled event has no
+// positive length, which a bitmap cannot represent (callers fall back to
+// can_schedule_at_time()).
+bool build_day_occupancy(DayOccupancy* day) {
+    memset(day, 0, sizeof(*day));
+    for (int i = 0; i < num_events; i++) {
+        if (!events[i].scheduled) continue;
+        int start = event_start_minutes(&events[i]), end = event_end_minutes(&events[i]);
+        if (end <= start) return false;
+        occupancy_mark(day, start, end);
+    }
+    return true;
+}
+
+// Optimized greedy scheduling using merge sort
+void greedy_interval_scheduling(RescheduleBudget* budget) {
+    if (num_events == 0) return;
+    
+    // Sort by priority and start time using merge sort - O(n log n)
+    sort_events_by(priority_sort_key);
+    reindex_after_sort();
+    
+    // Mark all as unscheduled
+    for (int i = 0; i < num_events; i++) {
+        events[i].scheduled = false;
+    }
+    
+    // Schedule greedily against a minute bitmap of everything accepted so
+    // far: O(n) word tests after the sort. The bitmap only holds
+    // positive-length events inside 00:00-24:00. A zero-length event, or one
+    // reaching past midnight, falls back to comparing with every earlier
+    // event, O(n²).
+    // Stopping early leaves the remaining events unscheduled, which is valid.
+    DayOccupancy day;
+    memset(&day, 0, sizeof(day));
+    bool use_bitmap = true;
+    for (int i = 0; i < num_events; i++) {
+        int start = event_start_minutes(&events[i]), end = event_end_minutes(&events[i]);
+        if (end <= start || start < 0 || end > DAY_MINUTES) use_bitmap = false;
+    }
+    
+    for (int i = 0; i < num_events && !budget_exhausted(budget); i++) {
+        bool can_schedule = true;
+        
+        if (use_bitmap) {
+            int start = event_start_minutes(&events[i]), end = event_end_minutes(&events[i]);
+            can_schedule = occupancy_free(&day, start, end);
+            if (can_schedule) occupancy_mark(&day, start, end);
+        } else {
+            // Check conflicts only with already scheduled events
+            for (int j = 0; j < i; j++) {
+                if (events[j].scheduled && 
+                    check_time_conflict(events[i].time, events[j].time)) {
+                    can_schedule = false;
+                    break;
+                }
+            }
+        }
+        
+        events[i].scheduled = can_schedule;
+    }
+}
+
+// Classic earliest-finish-time greedy: optimal event count for one room, O(n log n)
+void earliest_finish_scheduling(RescheduleBudget* budget) {
+    if (num_events == 0) return;
+    
+    sort_events_by(finish_sort_key);
+    reindex_after_sort();
+    
+    for (int i = 0; i < num_events; i++) {
+        events[i].scheduled = false;
+    }
+    
+    int last_end = INT_MIN;
+    for (int i = 0; i < num_events && !budget_exhausted(budget); i++) {
+        events[i].scheduled = event_start_minutes(&events[i]) >= last_end;
+        if (events[i].scheduled) {
+            last_end = event_end_minutes(&events[i]);
+        }
+    }
+}
+
+// k-room earliest finish time: each event goes to the room that frees up
+// latest but still before it starts (best fit), O(n log n + n k).
+// The track index is stored in track; color stays the graph coloring.
+void earliest_finish_k_scheduling(int k, RescheduleBudget* budget) {
+    if (num_events == 0) return;
+    if (k < 1) k = 1;
+    if (k > MAX_COLORS) k = MAX_COLORS;
+    
+    sort_events_by(finish_sort_key);
+    reindex_after_sort();
+    
+    // Track end times kept sorted ascending, paired with their track number
+    int track_end[MAX_COLORS];
+    int track_id[MAX_COLORS];
+    for (int t = 0; t < k; t++) {
+        track_end[t] = INT_MIN;
+        track_id[t] = t;
+    }
+    
+    for (int i = 0; i < num_events; i++) {
+        events[i].scheduled = false;
+    }
+    
+    for (int i = 0; i < num_events && !budget_exhausted(budget); i++) {
+        int start = event_start_minutes(&events[i]);
+        
+        // Binary search for the last track with end <= start
+        int lo = 0, hi = k - 1, best = -1;
+        while (lo <= hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (track_end[mid] <= start) {
+                best = mid;
+                lo = mid + 1;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        
+        if (best == -1) continue;
+        
+        events[i].scheduled = true;
+        events[i].track = track_id[best];
+        
+        // New end is the largest so far (sorted by finish), move it to the back
+        int moved_id = track_id[best];
+        for (int t = best; t < k - 1; t++) {
+            track_end[t] = track_end[t + 1];
+            track_id[t] = track_id[t + 1];
+        }
+        track_end[k - 1] = event_end_minutes(&events[i]);
+        track_id[k - 1] = moved_id;
+    }
+}
+
+const char* strategy_name(SchedulingStrategy strategy) {
+    switch (strategy) {
+        case STRATEGY_PRIORITY_GREEDY: return "Priority greedy";
+        case STRATEGY_EARLIEST_FINISH: return "Earliest finish";
+        case STRATEGY_EARLIEST_FINISH_K: return "Earliest finish (k rooms)";
+    }
+    return "Unknown";
+}
+
+void run_scheduling_strategy(SchedulingStrategy strategy, RescheduleBudget* budget) {
+    for (int i = 0; i < num_events; i++) {
+        events[i].track = -1;
+    }
+    
+    switch (strategy) {
+        case STRATEGY_PRIORITY_GREEDY:
+            greedy_interval_scheduling(budget);
+            break;
+        case STRATEGY_EARLIEST_FINISH:
+            earliest_finish_scheduling(budget);
+            break;
+        case STRATEGY_EARLIEST_FINISH_K:
+            earliest_finish_k_scheduling(eft_room_count > 0 ? eft_room_count :
+                                         (num_rooms > 0 ? num_rooms : 1), budget);
+            break;
+    }
+}
+
+// Trace capture (./scheduler --trace file <mode ...>): every public API
+// call is appended to a compact binary file that --replay re-executes
+// against any build. Layout: one TraceHeader, then a TraceRecord per call,
+// each followed by name_len bytes of event or room name (no terminator).
+// Records carry the time the call began, relative to the one before, and
+// calls made from inside another traced call are not recorded. Settings
+// that change what a call does are written as a CONFIG record ahead of the
+// first call that sees them.
+#define TRACE_MAGIC 0x52544353u    // "SCTR"
+#define TRACE_VERSION 1
+
+typedef enum {
+    TRACE_ADD = 1,           // id, start minute, duration, priority; name
+    TRACE_REMOVE,            // id
+    TRACE_UPDATE,            // id, start minute, duration, priority; name
+    TRACE_REQUIREMENTS,      // id, attendees, features
+    TRACE_ADD_ROOM,          // capacity, features; name
+    TRACE_EXPIRE,            // watermark minute
+    TRACE_BEGIN_BATCH,
+    TRACE_END_BATCH,
+    TRACE_RESCHEDULE,
+    TRACE_CONFIG,            // strategy, eft k, budget in microseconds
+    TRACE_LOOKUP,            // id
+    TRACE_FREE_SLOTS,        // duration
+    TRACE_CLEAR,
+    TRACE_ONLINE_BEGIN,
+    TRACE_ONLINE_ADD,        // id, start minute, duration, priority; name
+    TRACE_ONLINE_REMOVE,     // id
+    TRACE_ONLINE_REOPTIMIZE,
+    TRACE_ONLINE_END,
+    TRACE_OP_COUNT
+} TraceOp;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int32_t strategy;         // Settings when the trace started
+    int32_t eft_room_count;
+    int32_t budget_us;
+    int32_t reserved;
+} TraceHeader;
+
+typedef struct {
+    uint32_t delta_us;        // Since the previous record began
+    uint8_t op;               // TraceOp
+    uint8_t name_len;
+    uint16_t reserved;
+    int32_t args[4];
+} TraceRecord;
+
+_Static_assert(sizeof(TraceHeader) == 24 && sizeof(TraceRecord) == 24, "trace layout");
+
+FILE* trace_file = NULL;
+pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+double trace_last_ms = 0;
+_Thread_local int trace_depth = 0;   // Traced calls in progress on this thread
+long long trace_records = 0;
+TraceHeader trace_settings;       // Last settings written to the trace
+
+void trace_read_settings(TraceHeader* settings) {
+    settings->strategy = scheduling_strategy;
+    settings->eft_room_count = eft_room_count;
+    settings->budget_us = (int32_t)(reschedule_budget_ms * 1000);
+}
+
+// Start of a traced call: returns its start time, or 0 when it is not
+// recorded (tracing off, or nested in another traced call). Every call
+// must be paired with trace_end().
+double trace_begin() {
+    if (trace_file == NULL) return 0;
+    return trace_depth++ == 0 ? now_ms() : 0;
+}
+
+void trace_end(double began, TraceOp op, int a0, int a1, int a2, int a3, const char* name) {
+    if (trace_file == NULL) return;
+    trace_depth--;
+    if (began == 0) return;
+    
+    TraceRecord record;
+    size_t name_len = name != NULL ? strnlen(name, 255) : 0;
+    record.op = (uint8_t)op;
+    record.name_len = (uint8_t)name_len;
+    record.reserved = 0;
+    record.args[0] = a0;
+    record.args[1] = a1;
+    record.args[2] = a2;
+    record.args[3] = a3;
+    
+    pthread_mutex_lock(&trace_lock);
+    TraceHeader settings = trace_settings;
+    trace_read_settings(&settings);
+    double delta = began > trace_last_ms ? began - trace_last_ms : 0;
+    record.delta_us = delta * 1000 < UINT32_MAX ? (uint32_t)(delta * 1000) : UINT32_MAX;
+    trace_last_ms = began > trace_last_ms ? began : trace_last_ms;
+    if (trace_file != NULL) {
+        if (memcmp(&settings, &trace_settings, sizeof(settings)) != 0) {
+            TraceRecord config = {record.delta_us, TRACE_CONFIG, 0, 0,
+                                  {settings.strategy, settings.eft_room_count, settings.budget_us, 0}};
+            fwrite(&config, sizeof(config), 1, trace_file);
+            record.delta_us = 0;
+            trace_settings = settings;
+            trace_records++;
+        }
+        fwrite(&record, sizeof(record), 1, trace_file);
+        if (name_len > 0) fwrite(name, 1, name_len, trace_file);
+        trace_records++;
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
+
+bool trace_enable(const char* path) {
+    trace_file = fopen(path, "wb");
+    if (trace_file == NULL) {
+        printf("Could not open trace %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    TraceHeader header = {TRACE_MAGIC, TRACE_VERSION, 0, 0, 0, 0};
+    trace_read_settings(&header);
+    fwrite(&header, sizeof(header), 1, trace_file);
+    trace_settings = header;
+    trace_last_ms = now_ms();
+    return true;
+}
+
+void trace_disable() {
+    if (trace_file == NULL) return;
+    pthread_mutex_lock(&trace_lock);
+    fclose(trace_file);
+    trace_file = NULL;
+    printf("Trace: %lld calls recorded.\n", trace_records);
+    pthread_mutex_unlock(&trace_lock);
+}
+
+// Retention: events whose end passes a watermark are evicted in bulk. A
+// min-heap of (end minute, id) finds them without scanning events[]. Every
+// add and move pushes an entry; entries left behind by moved or removed
+// events are stale and skipped when popped, and a full heap is rebuilt
+// from the live events.
+#define EXPIRY_HEAP_CAPACITY (2 * MAX_EVENTS)
+#define RETENTION_CHECK_MS 60000      // Longest an idle server waits between expiry checks
+
+HeapEntry expiry_heap[EXPIRY_HEAP_CAPACITY];
+int expiry_heap_size = 0;
+bool retention_enabled = false;       // --retain: expire against the wall clock
+FILE* retention_archive = NULL;       // Evicted events, appended as SchedEventRecord
+long long events_expired = 0;
+
+void expiry_heap_rebuild() {
+    expiry_heap_size = 0;
+    for (int i = 0; i < num_events; i++) {
+        heap_push(expiry_heap, &expiry_heap_size, event_end_minutes(&events[i]), events[i].id);
+    }
+}
+
+// Called whenever an event gets a new end time
+void expiry_track(const Event* event) {
+    if (expiry_heap_size == EXPIRY_HEAP_CAPACITY) expiry_heap_rebuild();
+    heap_push(expiry_heap, &expiry_heap_size, event_end_minutes(event), event->id);
+}
+
+// Add event under an id reserved earlier from next_event_id (0 takes the
+// next one) and register it in the id index
+int add_event_with_id(int id, char* name, int start_hour, int start_minute, int duration_minutes, int priority) {
+    double began = trace_begin();
+    if (num_events >= MAX_EVENTS) {
+        if (verbose_output) printf("Cannot add more events. Maximum capacity reached.\n");
+        trace_end(began, TRACE_ADD, -1, start_hour * 60 + start_minute, duration_minutes, priority, name);
+        return -1;
+    }
+    
+    Event new_event;
+    new_event.id = id > 0 ? id : next_event_id++;
     strcpy(new_event.name, name);
     new_event.time.start_hour = start_hour;
     new_event.time.start_minute = start_minute;
     new_event.duration_minutes = duration_minutes;
     
-    // Calculate end time
-    int total_minutes = start_hour * 60 + start_minute + duration_minutes;
-    new_event.time.end_hour = total_minutes / 60;
-    new_event.time.end_minute = total_minutes % 60;
+    // Calculate end time
+    int total_minutes = start_hour * 60 + start_minute + duration_minutes;
+    new_event.time.end_hour = total_minutes / 60;
+    new_event.time.end_minute = total_minutes % 60;
+    
+    new_event.color = -1;
+    new_event.track = -1;
+    new_event.scheduled = false;
+    new_event.priority = priority;
+    new_event.degree = 0;
+    new_event.attendees = 0;
+    new_event.required_features = 0;
+    new_event.room = -1;
+    new_event.notify_set = -1;
+    
+    events[num_events] = new_event;
+    
+    id_index_insert(new_event.id, num_events);
+    expiry_track(&new_event);
+    
+    num_events++;
+    
+    if (verbose_output) {
+        printf("Event '%s' added successfully with ID: %d\n", name, new_event.id);
+    }
+    
+    // Rebuild and reschedule
+    if (batch_depth == 0) {
+        conflict_graph_changed();
+        reschedule_after_edit();
+    } else {
+        batch_graph_changed = true;
+    }
+    trace_end(began, TRACE_ADD, new_event.id, start_hour * 60 + start_minute, duration_minutes, priority, name);
+    return new_event.id;
+}
+
+int add_event(char* name, int start_hour, int start_minute, int duration_minutes, int priority) {
+    return add_event_with_id(0, name, start_hour, start_minute, duration_minutes, priority);
+}
+
+// Optimized remove event using the id index
+bool remove_event(int event_id) {
+    double began = trace_begin();
+    int index = find_event_index(event_id);
+    
+    if (index == -1) {
+        if (verbose_output) printf("Event with ID %d not found.\n", event_id);
+        trace_end(began, TRACE_REMOVE, event_id, 0, 0, 0, NULL);
+        return false;
+    }
+    
+    if (verbose_output) {
+        printf("Removing event '%s' (ID: %d)\n", events[index].name, event_id);
+    }
+    
+    notify_release(&events[index]);
+    id_index_remove(event_id);
+    
+    // Shift remaining events
+    for (int i = index; i < num_events - 1; i++) {
+        events[i] = events[i + 1];
+    }
+    num_events--;
+    
+    // Only the events that moved need their index updated
+    for (int i = index; i < num_events; i++) {
+        id_index_insert(events[i].id, i);
+    }
+    
+    // Rebuild and reschedule
+    if (batch_depth == 0) {
+        conflict_graph_changed();
+        reschedule_after_edit();
+    } else {
+        batch_graph_changed = true;
+    }
+    trace_end(began, TRACE_REMOVE, event_id, 0, 0, 0, NULL);
+    return true;
+}
+
+// Change an event's name, time, duration and priority in place. The id and
+// array index stay put, so the id index is untouched and a built conflict
+// graph only has this event's edges patched. A rename alone just publishes.
+bool update_event(int event_id, char* name, int start_hour, int start_minute, int duration_minutes, int priority) {
+    double began = trace_begin();
+    int index = find_event_index(event_id);
+    
+    if (index == -1) {
+        if (verbose_output) printf("Event with ID %d not found.\n", event_id);
+        trace_end(began, TRACE_UPDATE, event_id, start_hour * 60 + start_minute, duration_minutes, priority, name);
+        return false;
+    }
+    
+    Event* event = &events[index];
+    int start = start_hour * 60 + start_minute;
+    bool moved = start != event_start_minutes(event) || duration_minutes != event->duration_minutes;
+    bool reprioritized = priority != event->priority;
+    
+    strcpy(event->name, name);
+    event->time.start_hour = start_hour;
+    event->time.start_minute = start_minute;
+    event->time.end_hour = (start + duration_minutes) / 60;
+    event->time.end_minute = (start + duration_minutes) % 60;
+    event->duration_minutes = duration_minutes;
+    event->priority = priority;
+    
+    if (verbose_output) {
+        printf("Event '%s' (ID: %d) updated.\n", event->name, event_id);
+    }
+    
+    if (moved) {
+        conflict_graph_moved(index);
+        expiry_track(event);
+    }
+    if (batch_depth == 0) {
+        if (moved || reprioritized) {
+            reschedule_after_edit();
+        } else {
+            publish_snapshot();
+        }
+    }
+    trace_end(began, TRACE_UPDATE, event_id, start_hour * 60 + start_minute, duration_minutes, priority, name);
+    return true;
+}
+
+// Batch mode: group many add/remove calls behind a single rebuild. A batch
+// of in-place updates only reschedules.
+void begin_batch() {
+    double began = trace_begin();
+    batch_depth++;
+    trace_end(began, TRACE_BEGIN_BATCH, 0, 0, 0, 0, NULL);
+}
+
+void end_batch() {
+    double began = trace_begin();
+    if (batch_depth > 0 && --batch_depth == 0) {
+        if (batch_graph_changed) conflict_graph_changed();
+        batch_graph_changed = false;
+        dynamic_reschedule();
+    }
+    trace_end(began, TRACE_END_BATCH, 0, 0, 0, 0, NULL);
+}
+
+// Drop every event, index entry and graph edge (rooms and settings are kept)
+void clear_all_events() {
+    double began = trace_begin();
+    for (int i = 0; i < num_events; i++) {
+        notify_release(&events[i]);
+    }
+    id_index_clear();
+    clear_adjacency_lists();
+    conflict_graph.num_events = 0;
+    graph_dirty = true;
+    num_events = 0;
+    next_event_id = 1;
+    batch_depth = 0;
+    batch_graph_changed = false;
+    expiry_heap_size = 0;
+    trace_end(began, TRACE_CLEAR, 0, 0, 0, 0, NULL);
+}
+
+// Helper functions remain largely the same but optimized where possible
+int get_time_slot(int hour, int minute) {
+    return (hour * 60 + minute) / 30;
+}
+
+TimeSlot get_time_from_slot(int slot) {
+    TimeSlot time;
+    int total_minutes = slot * 30;
+    time.start_hour = total_minutes / 60;
+    time.start_minute = total_minutes % 60;
+    time.end_hour = (total_minutes + 30) / 60;
+    time.end_minute = (total_minutes + 30) % 60;
+    return time;
+}
+
+bool can_schedule_at_time(int event_id, TimeSlot time) {
+    for (int i = 0; i < num_events; i++) {
+        if (events[i].id != event_id && events[i].scheduled && 
+            check_time_conflict(time, events[i].time)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Move an unscheduled event to the given 30-minute slot
+void place_event_at_slot(int event_index, int slot) {
+    Event* event = &events[event_index];
+    TimeSlot alternative_time = get_time_from_slot(slot);
+    int end = alternative_time.start_hour * 60 + alternative_time.start_minute + event->duration_minutes;
+    alternative_time.end_hour = end / 60;
+    alternative_time.end_minute = end % 60;
+    
+    event->time = alternative_time;
+    event->scheduled = true;
+    event->color = slot;
+    graph_dirty = true;  // Moved event changes its conflicts
+    expiry_track(event);
+    if (verbose_output) {
+        printf("Rescheduled '%s' to alternative time: %02d:%02d-%02d:%02d\n", 
+               event->name, alternative_time.start_hour, alternative_time.start_minute,
+               alternative_time.end_hour, alternative_time.end_minute);
+    }
+}
+
+// Serial placement: each unscheduled event, in schedule order, takes the
+// first slot that fits around everything placed so far. Fit checks use a
+// minute bitmap, so each is a word or two rather than a scan of all events.
+void place_unscheduled_serial(RescheduleBudget* budget) {
+    DayOccupancy day;
+    bool use_bitmap = build_day_occupancy(&day);
+    
+    for (int i = 0; i < num_events && !budget_exhausted(budget); i++) {
+        if (!events[i].scheduled) {
+            bool rescheduled = false;
+            for (int slot = 0; slot < MAX_TIME_SLOTS - (events[i].duration_minutes / 30); slot++) {
+                if (budget_exhausted(budget)) break;
+                
+                TimeSlot alternative_time = get_time_from_slot(slot);
+                alternative_time.end_hour = (alternative_time.start_hour * 60 + 
+                                           alternative_time.start_minute + 
+                                           events[i].duration_minutes) / 60;
+                alternative_time.end_minute = (alternative_time.start_hour * 60 + 
+                                              alternative_time.start_minute + 
+                                              events[i].duration_minutes) % 60;
+                
+                int start = slot * 30;
+                bool fits = use_bitmap && events[i].duration_minutes > 0
+                    ? occupancy_free(&day, start, start + events[i].duration_minutes)
+                    : can_schedule_at_time(events[i].id, alternative_time);
+                if (fits) {
+                    place_event_at_slot(i, slot);
+                    if (use_bitmap) {
+                        if (events[i].duration_minutes > 0) occupancy_mark(&day, start, start + events[i].duration_minutes);
+                        else use_bitmap = false;
+                    }
+                    rescheduled = true;
+                    break;
+                }
+            }
+            
+            if (!rescheduled && verbose_output && !budget_exhausted(budget)) {
+                printf("Could not find alternative time slot for '%s'\n", events[i].name);
+            }
+        }
+    }
+}
+
+// True if [start, end) overlaps any interval in a start-sorted list whose
+// max_end[i] is the largest end among entries 0..i. O(log n).
+bool sorted_intervals_overlap(const int start[], const int max_end[], int count, int s, int e) {
+    // Last entry that starts before the candidate ends
+    int lo = 0, hi = count - 1, last = -1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (start[mid] < e) {
+            last = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return last >= 0 && max_end[last] > s;
+}
+
+// Read-only view of the scheduled intervals that workers test against.
+// Sorted by start with a running max of end times, so "does [s, e) hit any
+// scheduled event" is one binary search.
+typedef struct {
+    int count;
+    int start[MAX_EVENTS];
+    int max_end[MAX_EVENTS];  // Largest end among entries 0..i
+} PlacementSnapshot;
+
+void build_placement_snapshot(PlacementSnapshot* snapshot) {
+    static int order[MAX_EVENTS];
+    snapshot->count = collect_scheduled_by_start(order);
+    for (int k = 0; k < snapshot->count; k++) {
+        int end = event_end_minutes(&events[order[k]]);
+        snapshot->start[k] = event_start_minutes(&events[order[k]]);
+        snapshot->max_end[k] = k > 0 && snapshot->max_end[k - 1] > end ? snapshot->max_end[k - 1] : end;
+    }
+}
+
+bool snapshot_overlaps(const PlacementSnapshot* snapshot, int start, int end) {
+    return sorted_intervals_overlap(snapshot->start, snapshot->max_end, snapshot->count, start, end);
+}
+
+// First slot that fits against the snapshot, and against `committed` when
+// given, or -1. A non-zero seed rotates where each event starts looking so
+// speculative picks collide less often.
+int find_candidate_slot(const PlacementSnapshot* snapshot, const DayOccupancy* committed, const Event* event,
+                        unsigned long long seed) {
+    int slots = MAX_TIME_SLOTS - (event->duration_minutes / 30);
+    if (slots <= 0) return -1;
+    
+    int offset = 0;
+    if (seed != 0) {
+        unsigned long long mix = (seed ^ (unsigned long long)event->id) * 0x9E3779B97F4A7C15ULL;
+        offset = (int)((mix >> 33) % (unsigned long long)slots);
+    }
+    
+    for (int t = 0; t < slots; t++) {
+        int slot = (offset + t) % slots;
+        int start = slot * 30;
+        if (!snapshot_overlaps(snapshot, start, start + event->duration_minutes) &&
+            (committed == NULL || occupancy_free(committed, start, start + event->duration_minutes))) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+typedef struct {
+    const PlacementSnapshot* snapshot;
+    const int* pending;       // Event indices still looking for a slot
+    int* candidate;           // Output: chosen slot per pending entry
+    unsigned long long seed;
+} PlacementJob;
+
+void placement_task(void* arg, int begin, int end) {
+    PlacementJob* job = (PlacementJob*)arg;
+    for (int k = begin; k < end; k++) {
+        job->candidate[k] = find_candidate_slot(job->snapshot, NULL, &events[job->pending[k]], job->seed);
+    }
+}
+
+// Parallel speculative placement. Workers pick slots for all pending
+// events against one snapshot; the commit pass then walks them in schedule
+// (priority) order and keeps a pick if it misses everything committed
+// before it. A pick that clashes is searched again right away against the
+// snapshot plus those commits, so it is settled before any lower-priority
+// event commits, just as in the serial pass. Picks depend only on the
+// snapshot and seed, so the result is the same for any number of threads.
+void place_unscheduled_parallel(RescheduleBudget* budget, int num_workers) {
+    static PlacementSnapshot snapshot;
+    static int pending[MAX_EVENTS];
+    static int candidate[MAX_EVENTS];
+    DayOccupancy committed;     // Minutes taken by this pass
+    PlacementJob job = {&snapshot, pending, candidate, placement_seed};
+    int count = 0;
+    
+    for (int i = 0; i < num_events; i++) {
+        if (!events[i].scheduled) pending[count++] = i;
+    }
+    if (count == 0 || budget_exhausted(budget)) return;
+    
+    build_placement_snapshot(&snapshot);
+    parallel_for(0, count, 16, num_workers, placement_task, &job);
+    memset(&committed, 0, sizeof(committed));
+    
+    for (int k = 0; k < count && !budget_exhausted(budget); k++) {
+        int index = pending[k];
+        int duration = events[index].duration_minutes;
+        int slot = candidate[k];
+        if (slot != -1 && !occupancy_free(&committed, slot * 30, slot * 30 + duration)) {
+            slot = find_candidate_slot(&snapshot, &committed, &events[index], placement_seed);
+        }
+        if (slot == -1) {
+            // Nothing fits, and the schedule only fills up
+            if (verbose_output) {
+                printf("Could not find alternative time slot for '%s'\n", events[index].name);
+            }
+            continue;
+        }
+        place_event_at_slot(index, slot);
+        occupancy_mark(&committed, slot * 30, slot * 30 + duration);
+    }
+}
+
+// Use the parallel pass once the backlog is big enough to pay for tasks
+void place_unscheduled_events(RescheduleBudget* budget) {
+    int pending = 0;
+    for (int i = 0; i < num_events; i++) {
+        if (!events[i].scheduled) pending++;
+    }
+    
+    int workers = task_worker_count();
+    if (workers > 1 && pending >= PARALLEL_PLACEMENT_THRESHOLD) {
+        place_unscheduled_parallel(budget, workers);
+    } else {
+        place_unscheduled_serial(budget);
+    }
+}
+
+// Immutable published view of the event store, id index and schedule.
+// Readers never see it change; the writer builds a new one per update and
+// swaps it in, and old versions are freed once no reader can hold them.
+typedef struct ScheduleSnapshot {
+    unsigned long long version;
+    int num_events;
+    Event* events;            // Copy in schedule order
+    int* by_id;               // Positions in events[] sorted by id
+    int num_busy;
+    int* busy_start;          // Scheduled intervals sorted by start
+    int* busy_max_end;        // Running max end, see sorted_intervals_overlap()
+    unsigned long long retire_epoch;
+    struct ScheduleSnapshot* next_retired;   // Also links the free pool
+    int capacity;             // Events the arrays have room for
+} ScheduleSnapshot;
+
+// Epoch-based reclamation: a reader announces the global epoch before
+// loading the snapshot pointer and clears it when done. A retired snapshot
+// is freed once every announced epoch is newer than its retire epoch.
+typedef struct {
+    atomic_ullong epoch;      // 0 = not inside a read
+    atomic_bool in_use;
+} ReaderSlot;
+
+_Atomic(ScheduleSnapshot*) published_snapshot = NULL;
+atomic_ullong global_epoch = 1;
+ReaderSlot reader_slots[MAX_SNAPSHOT_READERS];
+_Thread_local int reader_slot_index = -1;
+ScheduleSnapshot* retired_snapshots = NULL;
+ScheduleSnapshot* free_snapshots = NULL;     // Reclaimed, ready for reuse
+int num_free_snapshots = 0;
+pthread_mutex_t snapshot_writer_lock = PTHREAD_MUTEX_INITIALIZER;
+unsigned long long snapshot_version = 0;
+
+#define SNAPSHOT_POOL_LIMIT 4         // Reclaimed snapshots kept beyond this are freed
+
+// Reuse a reclaimed snapshot with room for n events, else allocate one with
+// headroom so a growing store does not allocate on every publish. Pooled
+// snapshots too small for n are freed.
+ScheduleSnapshot* snapshot_alloc(int n) {
+    ScheduleSnapshot* snapshot = NULL;
+    
+    pthread_mutex_lock(&snapshot_writer_lock);
+    while (free_snapshots != NULL && snapshot == NULL) {
+        ScheduleSnapshot* candidate = free_snapshots;
+        free_snapshots = candidate->next_retired;
+        num_free_snapshots--;
+        if (candidate->capacity >= n) snapshot = candidate;
+        else free(candidate);
+    }
+    pthread_mutex_unlock(&snapshot_writer_lock);
+    
+    if (snapshot == NULL) {
+        int capacity = n + n / 4 + 64;
+        if (capacity > MAX_EVENTS) capacity = MAX_EVENTS;
+        size_t bytes = sizeof(ScheduleSnapshot) + (size_t)capacity * sizeof(Event) + 3 * (size_t)capacity * sizeof(int);
+        snapshot = (ScheduleSnapshot*)malloc(bytes);
+        snapshot->capacity = capacity;
+        snapshot->events = (Event*)(snapshot + 1);
+        snapshot->by_id = (int*)(snapshot->events + capacity);
+        snapshot->busy_start = snapshot->by_id + capacity;
+        snapshot->busy_max_end = snapshot->busy_start + capacity;
+    }
+    return snapshot;
+}
+
+ScheduleSnapshot* build_schedule_snapshot() {
+    static int order[MAX_EVENTS];
+    static int scratch[MAX_EVENTS];
+    int n = num_events;
+    
+    ScheduleSnapshot* snapshot = snapshot_alloc(n);
+    snapshot->num_events = n;
+    snapshot->next_retired = NULL;
+    
+    for (int i = 0; i < n; i++) {
+        snapshot->events[i] = events[i];
+    }
+    
+    // Id index: positions sorted by id (bottom-up merge sort), giving
+    // O(log n) lookups without copying the live id index
+    for (int i = 0; i < n; i++) {
+        snapshot->by_id[i] = i;
+    }
+    for (int width = 1; width < n; width *= 2) {
+        for (int left = 0; left < n - width; left += 2 * width) {
+            int mid = left + width, right = left + 2 * width < n ? left + 2 * width : n;
+            int i = left, j = mid, k = left;
+            while (i < mid && j < right) {
+                scratch[k++] = snapshot->events[snapshot->by_id[i]].id <= snapshot->events[snapshot->by_id[j]].id
+                               ? snapshot->by_id[i++] : snapshot->by_id[j++];
+            }
+            while (i < mid) scratch[k++] = snapshot->by_id[i++];
+            while (j < right) scratch[k++] = snapshot->by_id[j++];
+            for (k = left; k < right; k++) snapshot->by_id[k] = scratch[k];
+        }
+    }
+    
+    snapshot->num_busy = collect_scheduled_by_start(order);
+    for (int k = 0; k < snapshot->num_busy; k++) {
+        int end = event_end_minutes(&events[order[k]]);
+        snapshot->busy_start[k] = event_start_minutes(&events[order[k]]);
+        snapshot->busy_max_end[k] = k > 0 && snapshot->busy_max_end[k - 1] > end ? snapshot->busy_max_end[k - 1] : end;
+    }
+    return snapshot;
+}
+
+// Pool (or free) retired snapshots that no active reader can still be using
+void reclaim_snapshots() {
+    unsigned long long oldest_active = ULLONG_MAX;
+    for (int r = 0; r < MAX_SNAPSHOT_READERS; r++) {
+        unsigned long long epoch = atomic_load(&reader_slots[r].epoch);
+        if (epoch != 0 && epoch < oldest_active) oldest_active = epoch;
+    }
+    
+    ScheduleSnapshot** link = &retired_snapshots;
+    while (*link != NULL) {
+        ScheduleSnapshot* snapshot = *link;
+        if (snapshot->retire_epoch < oldest_active) {
+            *link = snapshot->next_retired;
+            if (num_free_snapshots < SNAPSHOT_POOL_LIMIT) {
+                snapshot->next_retired = free_snapshots;
+                free_snapshots = snapshot;
+                num_free_snapshots++;
+            } else {
+                free(snapshot);
+            }
+        } else {
+            link = &snapshot->next_retired;
+        }
+    }
+}
+
+// Change log between published versions, used to answer "what changed
+// since version v" without resending the schedule. Entries are appended
+// in version order; once the ring wraps, versions up to delta_log_floor
+// can only be answered with a full resync.
+#define DELTA_LOG_CAPACITY 16384
+
+// Delta replies fill DELTA_LOG_CAPACITY-sized buffers, and a full resync
+// writes every event into the same buffers
+_Static_assert(DELTA_LOG_CAPACITY >= MAX_EVENTS, "a delta buffer must hold a full resync");
+
+typedef struct {
+    unsigned long long version;
+    int event_id;
+    bool removed;
+} ScheduleChange;
+
+ScheduleChange delta_log[DELTA_LOG_CAPACITY];
+unsigned long long delta_log_count = 0;   // Entries ever appended
+unsigned long long delta_log_floor = 0;   // Oldest version still answerable
+
+// Everything a client can see about an event; degree is internal
+bool event_visibly_changed(const Event* a, const Event* b) {
+    return a->time.start_hour != b->time.start_hour || a->time.start_minute != b->time.start_minute ||
+           a->duration_minutes != b->duration_minutes || a->scheduled != b->scheduled ||
+           a->color != b->color || a->track != b->track || a->priority != b->priority || a->room != b->room ||
+           a->attendees != b->attendees || a->required_features != b->required_features ||
+           strcmp(a->name, b->name) != 0;
+}
+
+void delta_log_append(unsigned long long version, int event_id, bool removed) {
+    ScheduleChange* entry = &delta_log[delta_log_count % DELTA_LOG_CAPACITY];
+    if (delta_log_count >= DELTA_LOG_CAPACITY && entry->version > delta_log_floor) {
+        delta_log_floor = entry->version;
+    }
+    entry->version = version;
+    entry->event_id = event_id;
+    entry->removed = removed;
+    delta_log_count++;
+}
+
+// Walk both id-sorted indexes together and log what differs, O(n)
+void record_schedule_changes(const ScheduleSnapshot* old, const ScheduleSnapshot* next) {
+    int i = 0, j = 0;
+    int old_count = old != NULL ? old->num_events : 0;
+    
+    while (i < old_count || j < next->num_events) {
+        const Event* before = i < old_count ? &old->events[old->by_id[i]] : NULL;
+        const Event* after = j < next->num_events ? &next->events[next->by_id[j]] : NULL;
+        
+        if (after == NULL || (before != NULL && before->id < after->id)) {
+            delta_log_append(next->version, before->id, true);
+            i++;
+        } else if (before == NULL || after->id < before->id) {
+            delta_log_append(next->version, after->id, false);
+            j++;
+        } else {
+            if (event_visibly_changed(before, after)) delta_log_append(next->version, after->id, false);
+            i++;
+            j++;
+        }
+    }
+}
+
+// Ids changed after since_version, each once and newest first, with
+// removed[] set for ids that are gone. Both arrays need room for
+// DELTA_LOG_CAPACITY entries. Returns -1 if the log no longer reaches
+// that far back.
+int schedule_changes_since(unsigned long long since_version, int ids[], bool removed[]) {
+    static int seen_id[2 * DELTA_LOG_CAPACITY];          // Open-addressing set of ids
+    static unsigned int seen_stamp[2 * DELTA_LOG_CAPACITY];
+    static unsigned int stamp = 0;
+    
+    if (since_version < delta_log_floor) return -1;
+    stamp++;
+    
+    unsigned long long first = delta_log_count > DELTA_LOG_CAPACITY ? delta_log_count - DELTA_LOG_CAPACITY : 0;
+    int count = 0;
+    for (unsigned long long p = delta_log_count; p > first; p--) {
+        const ScheduleChange* entry = &delta_log[(p - 1) % DELTA_LOG_CAPACITY];
+        if (entry->version <= since_version) break;
+        
+        unsigned int slot = ((unsigned int)entry->event_id * 2654435761u) % (2 * DELTA_LOG_CAPACITY);
+        while (seen_stamp[slot] == stamp && seen_id[slot] != entry->event_id) {
+            slot = (slot + 1) % (2 * DELTA_LOG_CAPACITY);
+        }
+        if (seen_stamp[slot] == stamp) continue;  // A newer entry already covers this id
+        seen_stamp[slot] = stamp;
+        seen_id[slot] = entry->event_id;
+        
+        ids[count] = entry->event_id;
+        removed[count] = entry->removed;
+        count++;
+    }
+    return count;
+}
+
+// Wire/shared-memory form of an event (sched_protocol.h)
+void event_record(const Event* event, SchedEventRecord* record) {
+    memset(record, 0, sizeof(*record));
+    record->event_id = event->id;
+    record->start_minute = event_start_minutes(event);
+    record->end_minute = event_end_minutes(event);
+    record->priority = event->priority;
+    record->color = event->color;
+    record->room = event->room;
+    record->scheduled = event->scheduled;
+    strncpy(record->name, event->name, SCHED_RPC_NAME_LEN - 1);
+}
+
+// Evict every event that has ended by `watermark` (minutes from midnight)
+// in one compaction pass over events[], archiving each first. Costs
+// O(k log n) to find k expired events, plus the compaction and one
+// reschedule when anything went. Returns how many were evicted.
+int expire_events(int watermark) {
+    static bool evict[MAX_EVENTS];
+    double began = trace_begin();
+    int count = 0;
+    
+    while (expiry_heap_size > 0 && expiry_heap[0].key <= watermark) {
+        HeapEntry entry = heap_pop(expiry_heap, &expiry_heap_size);
+        int index = find_event_index(entry.value);
+        if (index == -1 || evict[index] || event_end_minutes(&events[index]) != entry.key) continue;  // Stale
+        evict[index] = true;
+        count++;
+    }
+    if (count == 0) {
+        trace_end(began, TRACE_EXPIRE, watermark, 0, 0, 0, NULL);
+        return 0;
+    }
+    
+    int kept = 0;
+    for (int i = 0; i < num_events; i++) {
+        if (evict[i]) {
+            evict[i] = false;
+            if (retention_archive != NULL) {
+                SchedEventRecord record;
+                event_record(&events[i], &record);
+                record.removed = 1;
+                fwrite(&record, sizeof(record), 1, retention_archive);
+            }
+            notify_release(&events[i]);
+            id_index_remove(events[i].id);
+            continue;
+        }
+        if (kept != i) {
+            events[kept] = events[i];
+            id_index_insert(events[kept].id, kept);
+        }
+        kept++;
+    }
+    num_events = kept;
+    events_expired += count;
+    if (retention_archive != NULL) fflush(retention_archive);
+    
+    if (verbose_output) {
+        printf("Expired %d events that ended by %02d:%02d.\n", count, watermark / 60, watermark % 60);
+    }
+    if (batch_depth == 0) {
+        conflict_graph_changed();
+        reschedule_after_edit();
+    } else {
+        batch_graph_changed = true;
+    }
+    trace_end(began, TRACE_EXPIRE, watermark, 0, 0, 0, NULL);
+    return count;
+}
+
+int wall_clock_minute() {
+    time_t now = time(NULL);
+    struct tm local;
+    localtime_r(&now, &local);
+    return local.tm_hour * 60 + local.tm_min;
+}
+
+// With --retain, expires against the wall clock
+void retention_tick(int minute) {
+    if (!retention_enabled) return;
+    if (expiry_heap_size > 0 && expiry_heap[0].key <= minute) expire_events(minute);
+}
+
+// ./scheduler --retain [archive file] <mode ...>
+bool retention_enable(const char* archive_path) {
+    if (archive_path != NULL) {
+        retention_archive = fopen(archive_path, "ab");
+        if (retention_archive == NULL) {
+            printf("Could not open archive %s: %s\n", archive_path, strerror(errno));
+            return false;
+        }
+    }
+    retention_enabled = true;
+    return true;
+}
+
+void retention_disable() {
+    if (retention_archive != NULL) fclose(retention_archive);
+    retention_archive = NULL;
+    retention_enabled = false;
+}
+
+// Hierarchical timing wheel in minutes. Level L has 64 slots of 64^L
+// minutes each, so three levels reach 182 days ahead. A timer sits in the
+// lowest level whose span covers its distance from `current`; whenever
+// level 0 wraps, the next slot of level 1 is cascaded down (and level 2
+// into level 1 when that wraps too). Add and cancel are O(1), and each
+// timer cascades at most twice before it fires, so advancing the wheel
+// costs O(1) per minute plus O(1) amortised per timer.
+#define WHEEL_LEVELS 3
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+
+typedef struct WheelTimer {
+    struct WheelTimer* next;
+    struct WheelTimer** pprev;      // Link pointing at this timer, NULL when not armed
+    int expires;                    // Minute it fires at
+} WheelTimer;
+
+typedef struct {
+    WheelTimer* slots[WHEEL_LEVELS][WHEEL_SLOTS];
+    int current;                    // Next minute to process
+    long long armed;
+} TimingWheel;
+
+typedef void (*WheelExpired)(WheelTimer* timer, void* context);
+
+void wheel_init(TimingWheel* wheel, int current) {
+    memset(wheel->slots, 0, sizeof(wheel->slots));
+    wheel->current = current;
+    wheel->armed = 0;
+}
+
+bool wheel_armed(const WheelTimer* timer) {
+    return timer->pprev != NULL;
+}
+
+// Arm a timer; one already due fires on the next advance
+void wheel_add(TimingWheel* wheel, WheelTimer* timer, int expires) {
+    int at = expires < wheel->current ? wheel->current : expires;
+    int delta = at - wheel->current;
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 && delta >= 1 << (WHEEL_BITS * (level + 1))) {
+        level++;
+    }
+    if (delta >= 1 << (WHEEL_BITS * WHEEL_LEVELS)) {
+        at = wheel->current + (1 << (WHEEL_BITS * WHEEL_LEVELS)) - 1;  // Re-cascaded until due
+    }
+    
+    WheelTimer** head = &wheel->slots[level][(at >> (WHEEL_BITS * level)) & WHEEL_MASK];
+    timer->expires = expires;
+    timer->next = *head;
+    if (*head != NULL) (*head)->pprev = &timer->next;
+    timer->pprev = head;
+    *head = timer;
+    wheel->armed++;
+}
+
+void wheel_cancel(TimingWheel* wheel, WheelTimer* timer) {
+    if (timer->pprev == NULL) return;
+    *timer->pprev = timer->next;
+    if (timer->next != NULL) timer->next->pprev = timer->pprev;
+    timer->next = NULL;
+    timer->pprev = NULL;
+    wheel->armed--;
+}
+
+// Re-file every timer of one slot one level down; returns the slot index
+int wheel_cascade(TimingWheel* wheel, int level) {
+    int index = (wheel->current >> (WHEEL_BITS * level)) & WHEEL_MASK;
+    WheelTimer* timer = wheel->slots[level][index];
+    wheel->slots[level][index] = NULL;
+    while (timer != NULL) {
+        WheelTimer* next = timer->next;
+        timer->pprev = NULL;
+        wheel->armed--;
+        wheel_add(wheel, timer, timer->expires);
+        timer = next;
+    }
+    return index;
+}
+
+// Fire every timer due up to and including minute `to`. Callbacks may add
+// and cancel timers.
+void wheel_advance(TimingWheel* wheel, int to, WheelExpired expired, void* context) {
+    while (wheel->current <= to) {
+        int index = wheel->current & WHEEL_MASK;
+        for (int level = 1; level < WHEEL_LEVELS && index == 0; level++) {
+            index = wheel_cascade(wheel, level);
+        }
+        
+        WheelTimer** head = &wheel->slots[0][wheel->current & WHEEL_MASK];
+        while (*head != NULL) {
+            WheelTimer* timer = *head;
+            wheel_cancel(wheel, timer);
+            expired(timer, context);
+        }
+        wheel->current++;
+    }
+}
+
+// Event notifications driven by the wheel: a reminder before the start,
+// "starting now" and "ending soon". Only scheduled events are armed. After
+// every reschedule each event's timers are compared with its new time and
+// re-armed only if it moved, so clients never track moves themselves.
+typedef enum {
+    NOTIFY_REMINDER,
+    NOTIFY_STARTING,
+    NOTIFY_ENDING_SOON,
+    NOTIFY_KINDS
+} NotifyKind;
+
+typedef void (*NotifyCallback)(const Event* event, NotifyKind kind, int minute, void* context);
+
+typedef struct {
+    WheelTimer timer;               // First, so a WheelTimer* is a NotifyTimer*
+    int event_id;
+    NotifyKind kind;
+} NotifyTimer;
+
+typedef struct {
+    NotifyTimer timers[NOTIFY_KINDS];
+    int start;                      // Interval the timers were armed for
+    int end;
+    int next_free;
+} NotifySet;
+
+NotifySet notify_sets[MAX_EVENTS];
+int notify_free = -1;
+int notify_sets_used = 0;
+TimingWheel notify_wheel;
+NotifyCallback notify_callback = NULL;   // NULL = notifications off
+void* notify_context = NULL;
+int reminder_lead_minutes = 15;
+int ending_soon_minutes = 5;
+long long notifications_fired = 0;
+
+const char* notify_kind_name(NotifyKind kind) {
+    switch (kind) {
+        case NOTIFY_REMINDER: return "reminder";
+        case NOTIFY_STARTING: return "starting now";
+        case NOTIFY_ENDING_SOON: return "ending soon";
+        default: return "unknown";
+    }
+}
+
+void notify_release(Event* event) {
+    if (event->notify_set == -1) return;
+    NotifySet* set = &notify_sets[event->notify_set];
+    for (int k = 0; k < NOTIFY_KINDS; k++) {
+        wheel_cancel(&notify_wheel, &set->timers[k].timer);
+    }
+    set->next_free = notify_free;
+    notify_free = event->notify_set;
+    event->notify_set = -1;
+}
+
+void notify_arm(Event* event) {
+    int start = event_start_minutes(event);
+    int end = event_end_minutes(event);
+    
+    if (event->notify_set == -1) {
+        if (notify_free != -1) {
+            event->notify_set = notify_free;
+            notify_free = notify_sets[notify_free].next_free;
+        } else {
+            event->notify_set = notify_sets_used++;
+        }
+        memset(&notify_sets[event->notify_set], 0, sizeof(NotifySet));
+    } else {
+        NotifySet* set = &notify_sets[event->notify_set];
+        if (set->start == start && set->end == end) return;
+        for (int k = 0; k < NOTIFY_KINDS; k++) {
+            wheel_cancel(&notify_wheel, &set->timers[k].timer);
+        }
+    }
+    
+    NotifySet* set = &notify_sets[event->notify_set];
+    int fire_at[NOTIFY_KINDS];
+    fire_at[NOTIFY_REMINDER] = start - reminder_lead_minutes;
+    fire_at[NOTIFY_STARTING] = start;
+    fire_at[NOTIFY_ENDING_SOON] = end - ending_soon_minutes > start ? end - ending_soon_minutes : -1;
+    set->start = start;
+    set->end = end;
+    for (int k = 0; k < NOTIFY_KINDS; k++) {
+        set->timers[k].event_id = event->id;
+        set->timers[k].kind = (NotifyKind)k;
+        if (fire_at[k] >= notify_wheel.current) {   // Times already passed today stay silent
+            wheel_add(&notify_wheel, &set->timers[k].timer, fire_at[k]);
+        }
+    }
+}
+
+// Called after every reschedule: O(1) per event that did not move
+void notify_sync() {
+    if (notify_callback == NULL) return;
+    for (int i = 0; i < num_events; i++) {
+        if (events[i].scheduled) {
+            notify_arm(&events[i]);
+        } else {
+            notify_release(&events[i]);
+        }
+    }
+}
+
+void notify_expired(WheelTimer* timer, void* context) {
+    NotifyTimer* notify = (NotifyTimer*)timer;
+    int index = find_event_index(notify->event_id);
+    (void)context;
+    if (index == -1) return;
+    notifications_fired++;
+    notify_callback(&events[index], notify->kind, timer->expires, notify_context);
+}
+
+// Fire every notification due by `minute`. A clock that went backwards
+// means a new day: the wheel restarts there and every event is re-armed.
+void notifications_tick(int minute) {
+    if (notify_callback == NULL) return;
+    if (minute < notify_wheel.current - 1) {
+        for (int i = 0; i < num_events; i++) notify_release(&events[i]);
+        wheel_init(&notify_wheel, minute);
+        notify_sync();
+    }
+    wheel_advance(&notify_wheel, minute, notify_expired, NULL);
+}
+
+// Notifications due before `current_minute` are skipped
+void notifications_enable(NotifyCallback callback, void* context, int current_minute) {
+    notify_callback = callback;
+    notify_context = context;
+    notify_free = -1;
+    notify_sets_used = 0;
+    for (int i = 0; i < num_events; i++) events[i].notify_set = -1;
+    wheel_init(&notify_wheel, current_minute);
+    notify_sync();
+}
+
+void print_notification(const Event* event, NotifyKind kind, int minute, void* context) {
+    (void)context;
+    printf("[%02d:%02d %s] '%s' (ID: %d) %02d:%02d-%02d:%02d\n", minute / 60, minute % 60, notify_kind_name(kind),
+           event->name, event->id, event->time.start_hour, event->time.start_minute,
+           event->time.end_hour, event->time.end_minute);
+    fflush(stdout);
+}
+
+// Called from each mode's loop: drives retention and notifications off the wall clock
+void clock_tick() {
+    if (!retention_enabled && notify_callback == NULL) return;
+    int minute = wall_clock_minute();
+    retention_tick(minute);
+    notifications_tick(minute);
+}
+
+// poll() timeout for loops that otherwise sleep until input arrives
+int clock_poll_timeout() {
+    if (notify_callback != NULL) return 1000;
+    return retention_enabled ? RETENTION_CHECK_MS : -1;
+}
+
+// Online booking: each arrival is decided immediately instead of through a
+// reschedule. A segment tree over the day's minutes keeps, per node, the
+// free run at its left edge, at its right edge and the longest inside, so
+// "is [s, e) free" and "first free run of d minutes from s" are O(log M)
+// for M minutes. An arrival is accepted at its requested time, else moved
+// to the first fit after it, else to the first fit of the day, else stored
+// unscheduled. Online mode holds one batch open, so arrivals never trigger
+// a rebuild; online_reoptimize() runs the deferred global reschedule
+// between arrivals and refreshes the tree from its result. Bookings are
+// final: the deferred pass never unschedules one. Online mode is driven
+// through this API only (hosts, --bench-online and --replay).
+#define ONLINE_TREE_LEAVES 2048   // Power of two >= DAY_MINUTES; the rest is always busy
+
+typedef struct {
+    int prefix[2 * ONLINE_TREE_LEAVES];
+    int suffix[2 * ONLINE_TREE_LEAVES];
+    int best[2 * ONLINE_TREE_LEAVES];
+    signed char assign[2 * ONLINE_TREE_LEAVES];   // Pending for the children: -1 none, 0 free, 1 busy
+} OccupancyTree;
+
+OccupancyTree online_tree;
+bool online_active = false;
+int online_pending = 0;           // Arrivals since the last reoptimisation
+long long online_accepted = 0;    // At the requested time
+long long online_moved = 0;
+long long online_rejected = 0;
+int online_booked_ids[MAX_EVENTS];   // Scheduled when the running deferred pass began
+int online_booked_count = 0;
+bool online_keeping = false;         // A deferred pass is running
+
+void tree_set(OccupancyTree* tree, int node, int length, bool busy) {
+    int free_run = busy ? 0 : length;
+    tree->prefix[node] = tree->suffix[node] = tree->best[node] = free_run;
+    tree->assign[node] = busy;
+}
+
+void tree_push(OccupancyTree* tree, int node, int length) {
+    if (tree->assign[node] == -1) return;
+    tree_set(tree, 2 * node, length / 2, tree->assign[node]);
+    tree_set(tree, 2 * node + 1, length / 2, tree->assign[node]);
+    tree->assign[node] = -1;
+}
+
+void tree_pull(OccupancyTree* tree, int node, int length) {
+    int half = length / 2, left = 2 * node, right = 2 * node + 1;
+    tree->prefix[node] = tree->prefix[left] == half ? half + tree->prefix[right] : tree->prefix[left];
+    tree->suffix[node] = tree->suffix[right] == half ? half + tree->suffix[left] : tree->suffix[right];
+    int best = tree->best[left] > tree->best[right] ? tree->best[left] : tree->best[right];
+    int across = tree->suffix[left] + tree->prefix[right];
+    tree->best[node] = across > best ? across : best;
+}
+
+void tree_assign(OccupancyTree* tree, int node, int l, int r, int from, int to, bool busy) {
+    if (to <= l || r <= from) return;
+    if (from <= l && r <= to) {
+        tree_set(tree, node, r - l, busy);
+        return;
+    }
+    tree_push(tree, node, r - l);
+    int mid = (l + r) / 2;
+    tree_assign(tree, 2 * node, l, mid, from, to, busy);
+    tree_assign(tree, 2 * node + 1, mid, r, from, to, busy);
+    tree_pull(tree, node, r - l);
+}
+
+// Leftmost run of d free minutes inside a node known to contain one
+int tree_leftmost(OccupancyTree* tree, int node, int l, int r, int d) {
+    while (r - l > 1) {
+        tree_push(tree, node, r - l);
+        int mid = (l + r) / 2;
+        if (tree->best[2 * node] >= d) {
+            node = 2 * node;
+            r = mid;
+        } else if (tree->suffix[2 * node] + tree->prefix[2 * node + 1] >= d) {
+            return mid - tree->suffix[2 * node];
+        } else {
+            node = 2 * node + 1;
+            l = mid;
+        }
+    }
+    return l;
+}
+
+// Walks the O(log M) nodes covering [from, end) left to right, carrying the
+// free run that ends at the current node, and descends into at most one
+void tree_first_fit(OccupancyTree* tree, int node, int l, int r, int from, int d, int* run, int* found) {
+    if (*found != -1 || r <= from) return;
+    if (from <= l) {
+        if (*run + tree->prefix[node] >= d) {
+            *found = l - *run;
+        } else if (tree->best[node] >= d) {
+            *found = tree_leftmost(tree, node, l, r, d);
+        } else {
+            *run = tree->prefix[node] == r - l ? *run + (r - l) : tree->suffix[node];
+        }
+        return;
+    }
+    tree_push(tree, node, r - l);
+    int mid = (l + r) / 2;
+    tree_first_fit(tree, 2 * node, l, mid, from, d, run, found);
+    tree_first_fit(tree, 2 * node + 1, mid, r, from, d, run, found);
+}
+
+// First start >= from with d free minutes inside the day, -1 if none
+int online_first_fit(int from, int d) {
+    int run = 0, found = -1;
+    tree_first_fit(&online_tree, 1, 0, ONLINE_TREE_LEAVES, from, d, &run, &found);
+    return found;
+}
+
+void online_mark(int start, int end, bool busy) {
+    if (end > DAY_MINUTES) end = DAY_MINUTES;
+    if (start < end) tree_assign(&online_tree, 1, 0, ONLINE_TREE_LEAVES, start, end, busy);
+}
+
+void online_rebuild_tree() {
+    tree_set(&online_tree, 1, ONLINE_TREE_LEAVES, false);
+    tree_assign(&online_tree, 1, 0, ONLINE_TREE_LEAVES, DAY_MINUTES, ONLINE_TREE_LEAVES, true);
+    for (int i = 0; i < num_events; i++) {
+        if (events[i].scheduled) online_mark(event_start_minutes(&events[i]), event_end_minutes(&events[i]), true);
+    }
+}
+
+// Runs right after the strategy during a deferred pass: every booking is
+// scheduled again, and anything the pass scheduled over one is dropped.
+// The later passes may still fit dropped arrivals around the bookings.
+void online_keep_bookings() {
+    static bool booked[MAX_EVENTS];
+    DayOccupancy day;
+    memset(&day, 0, sizeof(day));
+    memset(booked, 0, (size_t)num_events * sizeof(bool));
+    for (int k = 0; k < online_booked_count; k++) {
+        int index = find_event_index(online_booked_ids[k]);
+        if (index == -1) continue;
+        booked[index] = true;
+        events[index].scheduled = true;
+        int start = event_start_minutes(&events[index]);
+        occupancy_mark(&day, start, start + events[index].duration_minutes);
+    }
+    for (int i = 0; i < num_events; i++) {
+        int start = event_start_minutes(&events[i]);
+        if (!booked[i] && events[i].scheduled && !occupancy_free(&day, start, start + events[i].duration_minutes)) {
+            events[i].scheduled = false;
+        }
+    }
+}
+
+// Close the online batch with the bookings protected
+void online_run_pass() {
+    online_booked_count = 0;
+    for (int i = 0; i < num_events; i++) {
+        if (events[i].scheduled) online_booked_ids[online_booked_count++] = events[i].id;
+    }
+    online_keeping = true;
+    end_batch();
+    online_keeping = false;
+}
+
+void online_begin() {
+    double began = trace_begin();
+    dynamic_reschedule();
+    online_rebuild_tree();
+    online_pending = 0;
+    online_accepted = online_moved = online_rejected = 0;
+    online_active = true;
+    begin_batch();
+    trace_end(began, TRACE_ONLINE_BEGIN, 0, 0, 0, 0, NULL);
+}
+
+// The deferred global pass: rebuild, reschedule and publish everything that
+// arrived since the last one. It may improve on the online decisions.
+void online_reoptimize() {
+    if (!online_active) return;
+    double began = trace_begin();
+    online_run_pass();
+    online_rebuild_tree();
+    online_pending = 0;
+    begin_batch();
+    trace_end(began, TRACE_ONLINE_REOPTIMIZE, 0, 0, 0, 0, NULL);
+}
+
+void online_end() {
+    if (!online_active) return;
+    double began = trace_begin();
+    online_run_pass();
+    online_active = false;
+    trace_end(began, TRACE_ONLINE_END, 0, 0, 0, 0, NULL);
+}
+
+// Book one arrival: O(log M) to decide plus O(log n) to store (id index and
+// expiry heap). Returns the new id, or -1 if the store is full.
+// *placed_start is where it went, -1 if it is stored unscheduled.
+int online_add_event(char* name, int start_hour, int start_minute, int duration_minutes, int priority,
+                     int* placed_start) {
+    double began = trace_begin();
+    int start = start_hour * 60 + start_minute;
+    int fit = duration_minutes < DAY_MINUTES - start ? duration_minutes : DAY_MINUTES - start;
+    int placed = -1;
+    
+    if (fit <= 0 || online_first_fit(start, fit) == start) {
+        placed = start;
+    } else if (duration_minutes <= DAY_MINUTES) {
+        placed = online_first_fit(start, duration_minutes);
+        if (placed == -1) placed = online_first_fit(0, duration_minutes);
+    }
+    
+    int at = placed != -1 ? placed : start;
+    int id = add_event_with_id(0, name, at / 60, at % 60, duration_minutes, priority);
+    if (id != -1) {
+        // Counted once stored, so a full store does not show up as bookings
+        if (placed == start) {
+            online_accepted++;
+        } else if (placed != -1) {
+            online_moved++;
+        } else {
+            online_rejected++;
+        }
+        if (placed != -1) {
+            events[num_events - 1].scheduled = true;
+            online_mark(placed, placed + duration_minutes, true);
+        }
+        online_pending++;
+        if (placed_start != NULL) *placed_start = placed;
+    }
+    trace_end(began, TRACE_ONLINE_ADD, id, start, duration_minutes, priority, name);
+    return id;
+}
+
+// Scheduled events never overlap, so freeing one's minutes is exact
+bool online_remove_event(int event_id) {
+    double began = trace_begin();
+    int index = find_event_index(event_id);
+    if (index != -1 && events[index].scheduled) {
+        online_mark(event_start_minutes(&events[index]), event_end_minutes(&events[index]), false);
+    }
+    bool removed = remove_event(event_id);
+    trace_end(began, TRACE_ONLINE_REMOVE, event_id, 0, 0, 0, NULL);
+    return removed;
+}
+
+// Shared-memory copy of the published schedule for other processes
+// (./scheduler --shm [name]). Layout and reader protocol: sched_shm.h.
+_Static_assert(SCHED_SHM_CAPACITY >= MAX_EVENTS, "shared-memory buffers must hold every event");
+
+SchedShmRegion* shm_region = NULL;
+char shm_name[NAME_MAX + 1];
+
+void shm_write_snapshot(const ScheduleSnapshot* snapshot) {
+    // Fill the inactive buffer; readers are all on the other one
+    uint32_t index = 1 - (atomic_load_explicit(&shm_region->active, memory_order_relaxed) & 1);
+    SchedShmBuffer* buffer = &shm_region->buffers[index];
+    uint32_t sequence = atomic_load_explicit(&buffer->sequence, memory_order_relaxed);
+    
+    atomic_store_explicit(&buffer->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    buffer->count = (uint32_t)snapshot->num_events;
+    buffer->version = snapshot->version;
+    for (int i = 0; i < snapshot->num_events; i++) {
+        event_record(&snapshot->events[i], &buffer->events[i]);
+    }
+    atomic_store_explicit(&buffer->sequence, sequence + 2, memory_order_release);
+    
+    atomic_store_explicit(&shm_region->active, index, memory_order_release);
+    atomic_store_explicit(&shm_region->version, snapshot->version, memory_order_release);
+}
+
+// Create (or take over) the named region and publish the current schedule
+// into it from now on
+bool shm_enable(const char* name) {
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        perror(name);
+        return false;
+    }
+    if (ftruncate(fd, sizeof(SchedShmRegion)) < 0) {
+        perror(name);
+        close(fd);
+        return false;
+    }
+    void* memory = mmap(NULL, sizeof(SchedShmRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        perror(name);
+        return false;
+    }
+    
+    SchedShmRegion* region = (SchedShmRegion*)memory;
+    region->magic = 0;
+    region->layout_version = SCHED_SHM_LAYOUT_VERSION;
+    region->capacity = SCHED_SHM_CAPACITY;
+    region->writer_pid = (uint32_t)getpid();
+    atomic_store(&region->active, 0);
+    atomic_store(&region->version, 0);
+    atomic_store(&region->buffers[0].sequence, 0);
+    atomic_store(&region->buffers[1].sequence, 0);
+    region->buffers[0].count = 0;
+    region->buffers[0].version = 0;
+    atomic_thread_fence(memory_order_release);
+    region->magic = SCHED_SHM_MAGIC;
+    
+    snprintf(shm_name, sizeof(shm_name), "%s", name);
+    pthread_mutex_lock(&snapshot_writer_lock);
+    shm_region = region;
+    const ScheduleSnapshot* snapshot = atomic_load(&published_snapshot);
+    if (snapshot != NULL) shm_write_snapshot(snapshot);
+    pthread_mutex_unlock(&snapshot_writer_lock);
+    return true;
+}
+
+void shm_disable() {
+    if (shm_region == NULL) return;
+    munmap(shm_region, sizeof(SchedShmRegion));
+    shm_unlink(shm_name);
+    shm_region = NULL;
+}
+
+// Writer side: build the next version from the live state and swap it in.
+// Called after every committed change; readers are never blocked.
+void publish_snapshot() {
+    ScheduleSnapshot* snapshot = build_schedule_snapshot();
+    
+    pthread_mutex_lock(&snapshot_writer_lock);
+    snapshot->version = ++snapshot_version;
+    record_schedule_changes(atomic_load(&published_snapshot), snapshot);
+    if (shm_region != NULL) shm_write_snapshot(snapshot);
+    ScheduleSnapshot* old = atomic_exchange(&published_snapshot, snapshot);
+    if (old != NULL) {
+        old->retire_epoch = atomic_load(&global_epoch);
+        old->next_retired = retired_snapshots;
+        retired_snapshots = old;
+    }
+    atomic_fetch_add(&global_epoch, 1);
+    reclaim_snapshots();
+    pthread_mutex_unlock(&snapshot_writer_lock);
+}
+
+// Reader side: pin the current snapshot. Every thread gets its own slot on
+// first use; pair each acquire with snapshot_release().
+const ScheduleSnapshot* snapshot_acquire() {
+    if (reader_slot_index == -1) {
+        for (int r = 0; r < MAX_SNAPSHOT_READERS; r++) {
+            bool expected = false;
+            if (atomic_compare_exchange_strong(&reader_slots[r].in_use, &expected, true)) {
+                reader_slot_index = r;
+                break;
+            }
+        }
+        if (reader_slot_index == -1) return NULL;  // Too many reader threads
+    }
+    
+    atomic_store(&reader_slots[reader_slot_index].epoch, atomic_load(&global_epoch));
+    return atomic_load(&published_snapshot);
+}
+
+void snapshot_release() {
+    if (reader_slot_index != -1) {
+        atomic_store(&reader_slots[reader_slot_index].epoch, 0);
+    }
+}
+
+// Give the reader slot back when a reader thread exits
+void snapshot_unregister_reader() {
+    if (reader_slot_index != -1) {
+        atomic_store(&reader_slots[reader_slot_index].epoch, 0);
+        atomic_store(&reader_slots[reader_slot_index].in_use, false);
+        reader_slot_index = -1;
+    }
+}
+
+const Event* snapshot_find_event(const ScheduleSnapshot* snapshot, int event_id) {
+    int lo = 0, hi = snapshot->num_events - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        const Event* event = &snapshot->events[snapshot->by_id[mid]];
+        if (event->id == event_id) return event;
+        if (event->id < event_id) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return NULL;
+}
+
+// Start times (minutes, on 30-minute slots) where an event of this length
+// fits around the snapshot's schedule. Returns how many were written.
+int snapshot_find_free_slots(const ScheduleSnapshot* snapshot, int duration_minutes, int out_starts[], int max_out) {
+    int found = 0;
+    for (int slot = 0; slot < MAX_TIME_SLOTS - (duration_minutes / 30) && found < max_out; slot++) {
+        int start = slot * 30;
+        if (!sorted_intervals_overlap(snapshot->busy_start, snapshot->busy_max_end, snapshot->num_busy,
+                                      start, start + duration_minutes)) {
+            out_starts[found++] = start;
+        }
+    }
+    return found;
+}
+
+void print_free_slots(int duration_minutes) {
+    int starts[MAX_TIME_SLOTS];
+    double began = trace_begin();
+    const ScheduleSnapshot* snapshot = snapshot_acquire();
+    
+    if (snapshot == NULL) {
+        printf("No schedule published yet.\n");
+        snapshot_release();
+        trace_end(began, TRACE_FREE_SLOTS, duration_minutes, 0, 0, 0, NULL);
+        return;
+    }
+    
+    int found = snapshot_find_free_slots(snapshot, duration_minutes, starts, MAX_TIME_SLOTS);
+    trace_end(began, TRACE_FREE_SLOTS, duration_minutes, 0, 0, 0, NULL);
+    printf("\n=== FREE SLOTS FOR %d MINUTES (schedule version %llu) ===\n", duration_minutes, snapshot->version);
+    for (int k = 0; k < found; k++) {
+        int end = starts[k] + duration_minutes;
+        printf("%02d:%02d-%02d:%02d\n", starts[k] / 60, starts[k] % 60, end / 60, end % 60);
+    }
+    if (found == 0) printf("No free slot fits this duration.\n");
+    printf("==========================================\n\n");
+    snapshot_release();
+}
+
+const char* reschedule_status_name(RescheduleStatus status) {
+    switch (status) {
+        case RESCHEDULE_COMPLETE: return "complete";
+        case RESCHEDULE_DEADLINE_EXCEEDED: return "deadline exceeded";
+        case RESCHEDULE_CANCELLED: return "cancelled";
+    }
+    return "unknown";
+}
+
+// Reschedule within a deadline and/or cancellation token. The budget is
+// checked cooperatively in every inner loop; when it runs out the current
+// phase stops and the rest are skipped, so the result is always
+// conflict-free, just with more events left unscheduled.
+RescheduleStatus dynamic_reschedule_budgeted(RescheduleBudget* budget) {
+    if (verbose_output) printf("\n=== DYNAMIC RESCHEDULING ===\n");
+    
+    run_scheduling_strategy(scheduling_strategy, budget);
+    if (online_keeping) online_keep_bookings();
+    
+    int unscheduled_count = 0;
+    for (int i = 0; i < num_events; i++) {
+        if (!events[i].scheduled) {
+            unscheduled_count++;
+        }
+    }
+    
+    if (unscheduled_count > 0 && !budget_exhausted(budget)) {
+        if (verbose_output) {
+            printf("Warning: %d events could not be scheduled due to conflicts!\n", unscheduled_count);
+        }
+        
+        color_conflict_graph(budget);
+        
+        // Try alternative scheduling for unscheduled events
+        place_unscheduled_events(budget);
+    }
+    
+    if (num_rooms > 0) {
+        repair_room_assignment(budget);
+    }
+    
+    notify_sync();
+    publish_snapshot();
+    
+    RescheduleStatus status = budget != NULL ? budget->status : RESCHEDULE_COMPLETE;
+    if (verbose_output) {
+        if (status == RESCHEDULE_COMPLETE) {
+            printf("Rescheduling complete.\n");
+        } else {
+            printf("Rescheduling stopped early (%s); the schedule is valid but partial.\n",
+                   reschedule_status_name(status));
+            printf("Use Manual Reschedule to finish.\n");
+        }
+        printf("========================\n\n");
+    }
+    return status;
+}
+
+void dynamic_reschedule() {
+    dynamic_reschedule_budgeted(NULL);
+}
+
+// Edits reschedule under the interactive latency budget
+RescheduleStatus reschedule_after_edit() {
+    if (reschedule_budget_ms <= 0) {
+        return dynamic_reschedule_budgeted(NULL);
+    }
+    RescheduleBudget budget = make_budget(reschedule_budget_ms, NULL);
+    return dynamic_reschedule_budgeted(&budget);
+}
+
+bool room_fits_event(const Room* room, const Event* event) {
+    return room->capacity >= event->attendees &&
+           (room->features & event->required_features) == event->required_features;
+}
+
+// Hopcroft-Karp state for one time slice: events starting together vs free rooms
+typedef struct {
+    int num_left;
+    int left_event[MAX_EVENTS];     // Event index of each left vertex
+    int free_room[MAX_ROOMS];       // Room indices available in this slice
+    int num_free;
+    int match_left[MAX_EVENTS];     // Position in free_room[], -1 if unmatched
+    int match_right[MAX_ROOMS];     // Left vertex matched to free_room[r], -1 if none
+    int dist[MAX_EVENTS];
+} SliceMatching;
+
+bool hk_bfs(SliceMatching* m) {
+    static int queue[MAX_EVENTS];
+    int head = 0, tail = 0;
+    bool found_augmenting = false;
+    
+    for (int u = 0; u < m->num_left; u++) {
+        if (m->match_left[u] == -1) {
+            m->dist[u] = 0;
+            queue[tail++] = u;
+        } else {
+            m->dist[u] = INT_MAX;
+        }
+    }
+    
+    while (head < tail) {
+        int u = queue[head++];
+        for (int r = 0; r < m->num_free; r++) {
+            if (!room_fits_event(&rooms[m->free_room[r]], &events[m->left_event[u]])) continue;
+            int v = m->match_right[r];
+            if (v == -1) {
+                found_augmenting = true;
+            } else if (m->dist[v] == INT_MAX) {
+                m->dist[v] = m->dist[u] + 1;
+                queue[tail++] = v;
+            }
+        }
+    }
+    return found_augmenting;
+}
+
+bool hk_dfs(SliceMatching* m, int u) {
+    for (int r = 0; r < m->num_free; r++) {
+        if (!room_fits_event(&rooms[m->free_room[r]], &events[m->left_event[u]])) continue;
+        int v = m->match_right[r];
+        if (v == -1 || (m->dist[v] == m->dist[u] + 1 && hk_dfs(m, v))) {
+            m->match_left[u] = r;
+            m->match_right[r] = u;
+            return true;
+        }
+    }
+    m->dist[u] = INT_MAX;
+    return false;
+}
+
+// Maximum matching of one slice in O(E * sqrt(V))
+void hopcroft_karp(SliceMatching* m) {
+    for (int u = 0; u < m->num_left; u++) m->match_left[u] = -1;
+    for (int r = 0; r < m->num_free; r++) m->match_right[r] = -1;
+    
+    while (hk_bfs(m)) {
+        for (int u = 0; u < m->num_left; u++) {
+            if (m->match_left[u] == -1) {
+                hk_dfs(m, u);
+            }
+        }
+    }
+}
+
+// Full room assignment: sweep the day and run Hopcroft-Karp for every time
+// slice where events start, matching them against the rooms free at that moment
+void assign_rooms_full() {
+    static int order[MAX_EVENTS];
+    static SliceMatching slice;
+    int busy_until[MAX_ROOMS];
+    
+    for (int r = 0; r < num_rooms; r++) busy_until[r] = INT_MIN;
+    for (int i = 0; i < num_events; i++) events[i].room = -1;
+    
+    int count = collect_scheduled_by_start(order);
+    int pos = 0;
+    while (pos < count) {
+        int slice_start = event_start_minutes(&events[order[pos]]);
+        
+        slice.num_left = 0;
+        while (pos < count && event_start_minutes(&events[order[pos]]) == slice_start) {
+            slice.left_event[slice.num_left++] = order[pos++];
+        }
+        slice.num_free = 0;
+        for (int r = 0; r < num_rooms; r++) {
+            if (busy_until[r] <= slice_start) {
+                slice.free_room[slice.num_free++] = r;
+            }
+        }
+        
+        hopcroft_karp(&slice);
+        
+        for (int u = 0; u < slice.num_left; u++) {
+            if (slice.match_left[u] != -1) {
+                int room = slice.free_room[slice.match_left[u]];
+                Event* event = &events[slice.left_event[u]];
+                event->room = room;
+                busy_until[room] = event_end_minutes(event);
+            }
+        }
+    }
+}
+
+// Kuhn-style augmenting path: give event_index a room, moving at most one
+// overlapping occupant per room along the path. Only touches events on the path.
+bool augment_room(int event_index, bool room_visited[]) {
+    Event* event = &events[event_index];
+    
+    for (int r = 0; r < num_rooms; r++) {
+        if (room_visited[r] || !room_fits_event(&rooms[r], event)) continue;
+        room_visited[r] = true;
+        
+        int blocker = -1;
+        int blockers = 0;
+        for (int i = 0; i < num_events && blockers < 2; i++) {
+            if (i != event_index && events[i].room == r &&
+                check_time_conflict(events[i].time, event->time)) {
+                blocker = i;
+                blockers++;
+            }
+        }
+        
+        if (blockers == 0) {
+            event->room = r;
+            return true;
+        }
+        if (blockers == 1) {
+            events[blocker].room = -1;
+            if (augment_room(blocker, room_visited)) {
+                event->room = r;
+                return true;
+            }
+            events[blocker].room = r;
+        }
+    }
+    return false;
+}
+
+// Incremental repair after an edit: keep every assignment that is still valid,
+// then augment only the scheduled events that lost (or never had) a room
+void repair_room_assignment(RescheduleBudget* budget) {
+    static int order[MAX_EVENTS];
+    int busy_until[MAX_ROOMS];
+    bool room_visited[MAX_ROOMS];
+    bool any_assigned = false;
+    
+    for (int i = 0; i < num_events; i++) {
+        if (!events[i].scheduled || events[i].room >= num_rooms) {
+            events[i].room = -1;
+        }
+        if (events[i].room != -1) any_assigned = true;
+    }
+    if (!any_assigned && !budget_exhausted(budget)) {
+        assign_rooms_full();
+        return;
+    }
+    
+    for (int r = 0; r < num_rooms; r++) busy_until[r] = INT_MIN;
+    int count = collect_scheduled_by_start(order);
+    for (int k = 0; k < count; k++) {
+        Event* event = &events[order[k]];
+        int r = event->room;
+        if (r == -1) continue;
+        if (!room_fits_event(&rooms[r], event) || busy_until[r] > event_start_minutes(event)) {
+            event->room = -1;
+        } else {
+            busy_until[r] = event_end_minutes(event);
+        }
+    }
+    
+    // Validation above always runs so a stopped repair never leaves clashes
+    for (int i = 0; i < num_events && !budget_exhausted(budget); i++) {
+        if (events[i].scheduled && events[i].room == -1) {
+            for (int r = 0; r < num_rooms; r++) room_visited[r] = false;
+            augment_room(i, room_visited);
+        }
+    }
+}
+
+void add_room(char* name, int capacity, unsigned int features) {
+    double began = trace_begin();
+    if (num_rooms >= MAX_ROOMS) {
+        if (verbose_output) printf("Cannot add more rooms. Maximum capacity reached.\n");
+        trace_end(began, TRACE_ADD_ROOM, capacity, (int)features, 0, 0, name);
+        return;
+    }
+    
+    Room* room = &rooms[num_rooms++];
+    room->id = next_room_id++;
+    strcpy(room->name, name);
+    room->capacity = capacity;
+    room->features = features;
+    
+    if (verbose_output) {
+        printf("Room '%s' added successfully with ID: %d\n", name, room->id);
+    }
+    repair_room_assignment(NULL);
+    publish_snapshot();
+    trace_end(began, TRACE_ADD_ROOM, capacity, (int)features, 0, 0, name);
+}
+
+bool set_event_requirements(int event_id, int attendees, unsigned int required_features) {
+    double began = trace_begin();
+    int index = find_event_index(event_id);
+    
+    if (index == -1) {
+        if (verbose_output) printf("Event with ID %d not found.\n", event_id);
+        trace_end(began, TRACE_REQUIREMENTS, event_id, attendees, (int)required_features, 0, NULL);
+        return false;
+    }
+    
+    events[index].attendees = attendees;
+    events[index].required_features = required_features;
+    
+    if (batch_depth == 0) {
+        if (num_rooms > 0) {
+            repair_room_assignment(NULL);
+        }
+        publish_snapshot();
+    }
+    trace_end(began, TRACE_REQUIREMENTS, event_id, attendees, (int)required_features, 0, NULL);
+    return true;
+}
+
+void print_features(unsigned int features) {
+    if (features == 0) {
+        printf("-");
+        return;
+    }
+    if (features & FEATURE_PROJECTOR) printf("projector ");
+    if (features & FEATURE_LAB_BENCHES) printf("lab-benches ");
+    if (features & FEATURE_VIDEO_CONF) printf("video-conf ");
+    if (features & FEATURE_WHITEBOARD) printf("whiteboard ");
+}
+
+void print_room_assignment() {
+    printf("\n=== ROOM ASSIGNMENT ===\n");
+    printf("Rooms:\n");
+    for (int r = 0; r < num_rooms; r++) {
+        printf("  %d. %-20s capacity %-4d features: ", rooms[r].id, rooms[r].name, rooms[r].capacity);
+        print_features(rooms[r].features);
+        printf("\n");
+    }
+    printf("%-4s %-20s %-12s %-9s %-20s\n", "ID", "Event Name", "Time", "Attendees", "Room");
+    printf("------------------------------------------------------------\n");
+    for (int i = 0; i < num_events; i++) {
+        if (!events[i].scheduled) continue;
+        printf("%-4d %-20s %02d:%02d-%02d:%02d %-9d %-20s\n",
+               events[i].id, events[i].name,
+               events[i].time.start_hour, events[i].time.start_minute,
+               events[i].time.end_hour, events[i].time.end_minute,
+               events[i].attendees,
+               events[i].room != -1 ? rooms[events[i].room].name : "(no room available)");
+    }
+    printf("========================================\n\n");
+}
+
+// iCalendar (.ics) import and export, the RFC 5545 subset calendar systems
+// emit for plain meetings. Both stream: the importer holds one unfolded
+// content line and the fields of the VEVENT being read, and the exporter
+// writes straight from a snapshot, so memory does not grow with the file.
+// The engine models one day, so an import either takes every VEVENT at its
+// time of day, or only the VEVENTs that occur on one date (RRULE expanded
+// arithmetically, EXDATE honoured). Times are wall-clock; UTC times (Z)
+// are converted to local time, and TZID parameters are ignored.
+#define ICS_LINE_MAX 1024          // Longer content lines are truncated
+#define ICS_NO_DAY INT_MIN
+
+typedef enum {
+    ICS_FREQ_NONE,
+    ICS_FREQ_DAILY,
+    ICS_FREQ_WEEKLY,
+    ICS_FREQ_MONTHLY,
+    ICS_FREQ_YEARLY
+} IcsFrequency;
+
+typedef struct {
+    int day;          // Days since 1970-01-01
+    int minute;       // Minutes from midnight
+    bool has_time;    // False for VALUE=DATE (all-day)
+} IcsTime;
+
+typedef struct {
+    IcsFrequency freq;
+    int interval;
+    int count;                 // 0 = unbounded
+    int until_day;             // ICS_NO_DAY = unbounded
+    int num_by_day;
+    int by_weekday[7];         // 0 = Monday
+    int by_ordinal[7];         // 0 = every such weekday, 1..5 or -1 = nth / last in the month
+} IcsRule;
+
+typedef struct {
+    char summary[50];
+    IcsTime start, end;
+    bool has_start, has_end, has_duration;
+    int duration;              // From DURATION, -1 if unreadable
+    int priority;              // iCalendar 0-9, 0 = undefined
+    IcsRule rule;
+    bool excluded;             // An EXDATE names the target day
+} IcsEvent;
+
+typedef struct {
+    long long vevents;
+    long long imported;
+    long long all_day;         // Skipped: no time of day
+    long long other_day;       // Skipped: does not occur on the target day
+    long long invalid;         // Skipped: no start, or an end before it
+    long long rejected;        // The event store was full
+} IcsImportStats;
+
+// Proleptic Gregorian calendar <-> days since 1970-01-01
+int days_from_civil(int year, int month, int day) {
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int year_of_era = year - era * 400;
+    int day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+void civil_from_days(int days, int* year, int* month, int* day) {
+    days += 719468;
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    int day_of_era = days - era * 146097;
+    int year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    int day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    int mp = (5 * day_of_year + 2) / 153;
+    *day = day_of_year - (153 * mp + 2) / 5 + 1;
+    *month = mp + (mp < 10 ? 3 : -9);
+    *year = year_of_era + era * 400 + (*month <= 2);
+}
+
+int weekday_of(int days) {
+    return ((days + 3) % 7 + 7) % 7;   // 1970-01-01 was a Thursday; 0 = Monday
+}
+
+int today_day() {
+    time_t now = time(NULL);
+    struct tm local;
+    localtime_r(&now, &local);
+    return days_from_civil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+}
+
+// "20240115", "20240115T093000" or "20240115T093000Z". Only characters
+// sscanf consumed are looked past, so short values stay inside the string.
+bool parse_ics_time(const char* value, IcsTime* out) {
+    int year, month, day, hour = 0, minute = 0, second = 0, date_len = 0, time_len = 0;
+    if (sscanf(value, "%4d%2d%2d%n", &year, &month, &day, &date_len) != 3) return false;
+    out->day = days_from_civil(year, month, day);
+    const char* time = value + date_len;
+    out->has_time = *time == 'T' &&
+                    sscanf(time + 1, "%2d%2d%n%2d%n", &hour, &minute, &time_len, &second, &time_len) >= 2;
+    out->minute = out->has_time ? hour * 60 + minute : 0;
+    
+    if (out->has_time && time[1 + time_len] == 'Z') {
+        time_t utc = (time_t)out->day * 86400 + (time_t)out->minute * 60;
+        struct tm local;
+        localtime_r(&utc, &local);
+        out->day = days_from_civil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+        out->minute = local.tm_hour * 60 + local.tm_min;
+    }
+    return true;
+}
+
+// "PT1H30M", "P1D", "P1DT2H": minutes, -1 if unreadable
+int parse_ics_duration(const char* value) {
+    int minutes = 0, number = 0;
+    bool in_time = false, any = false;
+    if (*value == '+' || *value == '-') value++;
+    if (*value++ != 'P') return -1;
+    for (; *value != '\0'; value++) {
+        if (*value >= '0' && *value <= '9') {
+            number = number * 10 + (*value - '0');
+            continue;
+        }
+        switch (*value) {
+            case 'T': in_time = true; break;
+            case 'W': minutes += number * 7 * 24 * 60; break;
+            case 'D': minutes += number * 24 * 60; break;
+            case 'H': minutes += number * 60; break;
+            case 'M': if (in_time) minutes += number; break;
+            case 'S': break;
+            default: return -1;
+        }
+        any = true;
+        number = 0;
+    }
+    return any ? minutes : -1;
+}
+
+int ics_weekday(const char* code) {
+    static const char* codes[7] = {"MO", "TU", "WE", "TH", "FR", "SA", "SU"};
+    for (int d = 0; d < 7; d++) {
+        if (strncmp(code, codes[d], 2) == 0) return d;
+    }
+    return -1;
+}
+
+// FREQ=WEEKLY;INTERVAL=2;BYDAY=MO,WE;UNTIL=20241231T235959Z;COUNT=10
+void parse_ics_rule(char* value, IcsRule* rule) {
+    char* save = NULL;
+    for (char* part = strtok_r(value, ";", &save); part != NULL; part = strtok_r(NULL, ";", &save)) {
+        char* equals = strchr(part, '=');
+        if (equals == NULL) continue;
+        *equals = '\0';
+        const char* arg = equals + 1;
+        
+        if (strcmp(part, "FREQ") == 0) {
+            rule->freq = strcmp(arg, "DAILY") == 0 ? ICS_FREQ_DAILY : strcmp(arg, "WEEKLY") == 0 ? ICS_FREQ_WEEKLY :
+                         strcmp(arg, "MONTHLY") == 0 ? ICS_FREQ_MONTHLY :
+                         strcmp(arg, "YEARLY") == 0 ? ICS_FREQ_YEARLY : ICS_FREQ_NONE;
+        } else if (strcmp(part, "INTERVAL") == 0) {
+            rule->interval = atoi(arg) > 0 ? atoi(arg) : 1;
+        } else if (strcmp(part, "COUNT") == 0) {
+            rule->count = atoi(arg);
+        } else if (strcmp(part, "UNTIL") == 0) {
+            IcsTime until;
+            if (parse_ics_time(arg, &until)) rule->until_day = until.day;
+        } else if (strcmp(part, "BYDAY") == 0) {
+            rule->num_by_day = 0;
+            while (*arg != '\0' && rule->num_by_day < 7) {
+                char* end;
+                int ordinal = (int)strtol(arg, &end, 10);
+                int weekday = ics_weekday(end);
+                if (weekday >= 0) {
+                    rule->by_weekday[rule->num_by_day] = weekday;
+                    rule->by_ordinal[rule->num_by_day++] = ordinal;
+                }
+                arg = strchr(end, ',');
+                if (arg == NULL) break;
+                arg++;
+            }
+        }
+    }
+}
+
+bool ics_rule_has_weekday(const IcsRule* rule, int weekday) {
+    for (int k = 0; k < rule->num_by_day; k++) {
+        if (rule->by_weekday[k] == weekday) return true;
+    }
+    return false;
+}
+
+// Weekly BYDAY occurrences in [from, to) weekdays of one week
+int ics_rule_days_between(const IcsRule* rule, int from, int to) {
+    int count = 0;
+    for (int weekday = from; weekday < to; weekday++) {
+        if (ics_rule_has_weekday(rule, weekday)) count++;
+    }
+    return count;
+}
+
+// Whether a recurring event has an instance on `day`. COUNT is applied
+// exactly for DAILY, WEEKLY and YEARLY, and per month for MONTHLY.
+bool ics_occurs_on(const IcsEvent* event, int day) {
+    const IcsRule* rule = &event->rule;
+    int start = event->start.day;
+    if (event->excluded || day < start) return false;
+    if (rule->freq == ICS_FREQ_NONE) return day == start;
+    if (rule->until_day != ICS_NO_DAY && day > rule->until_day) return false;
+    
+    int weekday = weekday_of(day);
+    long long index;
+    switch (rule->freq) {
+        case ICS_FREQ_DAILY:
+            if ((day - start) % rule->interval != 0) return false;
+            index = (day - start) / rule->interval;
+            if (rule->num_by_day > 0) {
+                if (!ics_rule_has_weekday(rule, weekday)) return false;
+                // Only instances on a BYDAY weekday count toward COUNT. Their
+                // weekdays repeat every 7 instances (every one if INTERVAL is
+                // a multiple of 7), so count one period and the part before day.
+                int period = rule->interval % 7 == 0 ? 1 : 7;
+                long long per_period = 0, before = 0;
+                for (int k = 0; k < period; k++) {
+                    bool match = ics_rule_has_weekday(rule, weekday_of(start + k * (rule->interval % 7)));
+                    per_period += match;
+                    if (k < index % period) before += match;
+                }
+                index = index / period * per_period + before;
+            }
+            break;
+        case ICS_FREQ_WEEKLY: {
+            int first = weekday_of(start);
+            int weeks = ((day - weekday) - (start - first)) / 7;
+            if (weeks % rule->interval != 0) return false;
+            if (rule->num_by_day == 0) {
+                if (weekday != first) return false;
+                index = weeks / rule->interval;
+            } else {
+                if (!ics_rule_has_weekday(rule, weekday)) return false;
+                if (weeks == 0) {
+                    index = ics_rule_days_between(rule, first, weekday);
+                } else {
+                    index = ics_rule_days_between(rule, first, 7) +
+                            (long long)(weeks / rule->interval - 1) * rule->num_by_day +
+                            ics_rule_days_between(rule, 0, weekday);
+                }
+            }
+            break;
+        }
+        case ICS_FREQ_MONTHLY:
+        case ICS_FREQ_YEARLY: {
+            int sy, sm, sd, ty, tm, td;
+            civil_from_days(start, &sy, &sm, &sd);
+            civil_from_days(day, &ty, &tm, &td);
+            int months = (ty - sy) * 12 + tm - sm;
+            if (rule->freq == ICS_FREQ_YEARLY) {
+                if (tm != sm || td != sd || (ty - sy) % rule->interval != 0) return false;
+                index = (ty - sy) / rule->interval;
+                break;
+            }
+            if (months % rule->interval != 0) return false;
+            if (rule->num_by_day == 0) {
+                if (td != sd) return false;
+            } else {
+                int days_in_month = days_from_civil(tm == 12 ? ty + 1 : ty, tm == 12 ? 1 : tm + 1, 1) -
+                                    days_from_civil(ty, tm, 1);
+                bool match = false;
+                for (int k = 0; k < rule->num_by_day && !match; k++) {
+                    int ordinal = rule->by_ordinal[k];
+                    match = rule->by_weekday[k] == weekday &&
+                            (ordinal == 0 || (ordinal > 0 && (td - 1) / 7 + 1 == ordinal) ||
+                             (ordinal == -1 && td + 7 > days_in_month));
+                }
+                if (!match) return false;
+            }
+            index = months / rule->interval;
+            break;
+        }
+        default:
+            return false;
+    }
+    return rule->count <= 0 || index < rule->count;
+}
+
+// iCalendar PRIORITY 1 (highest) .. 9 (lowest), 0 undefined <-> 5 .. 1
+int priority_from_ics(int priority) {
+    return priority >= 1 && priority <= 9 ? 5 - (priority - 1) / 2 : 3;
+}
+
+int priority_to_ics(int priority) {
+    return priority >= 1 && priority <= 5 ? 11 - 2 * priority : 0;
+}
+
+// Read one content line, unfolding continuation lines (CRLF followed by a
+// space or tab). False at end of file.
+bool ics_read_line(FILE* in, char line[ICS_LINE_MAX]) {
+    size_t len = 0;
+    int c = getc_unlocked(in);
+    if (c == EOF) return false;
+    
+    for (;;) {
+        if (c == EOF) break;
+        if (c == '\n') {
+            int next = getc_unlocked(in);
+            if (next != ' ' && next != '\t') {
+                if (next != EOF) ungetc(next, in);
+                break;
+            }
+        } else if (c != '\r' && len < ICS_LINE_MAX - 1) {
+            line[len++] = (char)c;
+        }
+        c = getc_unlocked(in);
+    }
+    line[len] = '\0';
+    return true;
+}
+
+// Undo TEXT escaping (\, \; \n \\) into a name-sized buffer
+void ics_unescape(const char* value, char* out, size_t cap) {
+    size_t len = 0;
+    for (; *value != '\0' && len < cap - 1; value++) {
+        if (*value == '\\' && value[1] != '\0') {
+            value++;
+            out[len++] = *value == 'n' || *value == 'N' ? ' ' : *value;
+        } else {
+            out[len++] = *value;
+        }
+    }
+    out[len] = '\0';
+}
+
+void ics_commit_event(const IcsEvent* event, int target_day, IcsImportStats* stats) {
+    if (!event->has_start) {
+        stats->invalid++;
+        return;
+    }
+    if (!event->start.has_time) {
+        stats->all_day++;
+        return;
+    }
+    if (target_day != ICS_NO_DAY && !ics_occurs_on(event, target_day)) {
+        stats->other_day++;
+        return;
+    }
+    
+    // RFC 5545: a timed DTSTART with neither DTEND nor DURATION has no length
+    int duration = event->has_end ? (event->end.day - event->start.day) * 24 * 60 + event->end.minute -
+                                    event->start.minute
+                 : event->has_duration ? event->duration
+                                       : 0;
+    if (duration > 24 * 60 - event->start.minute) duration = 24 * 60 - event->start.minute;
+    if (duration < 0) {
+        stats->invalid++;
+        return;
+    }
+    
+    char name[50];
+    strcpy(name, event->summary[0] != '\0' ? event->summary : "(no title)");
+    if (add_event(name, event->start.minute / 60, event->start.minute % 60, duration,
+                  priority_from_ics(event->priority)) == -1) {
+        stats->rejected++;
+    } else {
+        stats->imported++;
+    }
+}
+
+// Load every VEVENT (target_day ICS_NO_DAY) or those occurring on
+// target_day as one batch with a single rebuild. False if the file could
+// not be opened.
+bool import_ics(const char* path, int target_day, IcsImportStats* stats) {
+    FILE* in = fopen(path, "r");
+    if (in == NULL) return false;
+    
+    char line[ICS_LINE_MAX];
+    IcsEvent event;
+    bool in_event = false;
+    int nested = 0;            // VALARM and other components inside the VEVENT
+    memset(stats, 0, sizeof(*stats));
+    
+    bool was_verbose = verbose_output;   // Quiet per-event capacity messages; they are counted instead
+    verbose_output = false;
+    flockfile(in);
+    begin_batch();
+    while (ics_read_line(in, line)) {
+        // NAME;PARAM=...:VALUE; a quoted parameter value may contain ':'
+        char* value = line;
+        bool quoted = false;
+        while (*value != '\0' && (quoted || *value != ':')) {
+            if (*value == '"') quoted = !quoted;
+            value++;
+        }
+        if (*value == '\0') continue;
+        *value++ = '\0';
+        char* params = strchr(line, ';');
+        if (params != NULL) *params++ = '\0';
+        
+        if (strcmp(line, "BEGIN") == 0) {
+            if (in_event) {
+                nested++;
+            } else if (strcmp(value, "VEVENT") == 0) {
+                memset(&event, 0, sizeof(event));
+                event.duration = -1;
+                event.rule.interval = 1;
+                event.rule.until_day = ICS_NO_DAY;
+                in_event = true;
+                stats->vevents++;
+            }
+            continue;
+        }
+        if (!in_event) continue;
+        if (strcmp(line, "END") == 0) {
+            if (nested > 0) {
+                nested--;
+            } else {
+                ics_commit_event(&event, target_day, stats);
+                in_event = false;
+            }
+            continue;
+        }
+        if (nested > 0) continue;
+        
+        if (strcmp(line, "SUMMARY") == 0) {
+            ics_unescape(value, event.summary, sizeof(event.summary));
+        } else if (strcmp(line, "DTSTART") == 0) {
+            event.has_start = parse_ics_time(value, &event.start);
+        } else if (strcmp(line, "DTEND") == 0) {
+            event.has_end = parse_ics_time(value, &event.end);
+        } else if (strcmp(line, "DURATION") == 0) {
+            event.duration = parse_ics_duration(value);
+            event.has_duration = true;
+        } else if (strcmp(line, "PRIORITY") == 0) {
+            event.priority = atoi(value);
+        } else if (strcmp(line, "RRULE") == 0) {
+            parse_ics_rule(value, &event.rule);
+        } else if (strcmp(line, "EXDATE") == 0 && target_day != ICS_NO_DAY) {
+            char* save = NULL;
+            for (char* date = strtok_r(value, ",", &save); date != NULL; date = strtok_r(NULL, ",", &save)) {
+                IcsTime excluded;
+                if (parse_ics_time(date, &excluded) && excluded.day == target_day) event.excluded = true;
+            }
+        }
+    }
+    funlockfile(in);
+    fclose(in);
+    verbose_output = was_verbose;
+    end_batch();
+    return true;
+}
+
+// Write one content line, folded at 75 octets
+void ics_write_line(FILE* out, const char* name, const char* value) {
+    int column = fprintf(out, "%s:", name);
+    for (; *value != '\0'; value++) {
+        if (column >= 75) {
+            fputs("\r\n ", out);
+            column = 1;
+        }
+        putc_unlocked(*value, out);
+        column++;
+    }
+    fputs("\r\n", out);
+}
+
+void ics_escape(const char* value, char* out, size_t cap) {
+    size_t len = 0;
+    for (; *value != '\0' && len + 2 < cap; value++) {
+        if (*value == '\\' || *value == ';' || *value == ',') out[len++] = '\\';
+        out[len++] = *value;
+    }
+    out[len] = '\0';
+}
+
+// Write the published schedule as a VCALENDAR with every event on `day`.
+// Unscheduled events are exported as TENTATIVE. Returns the number
+// written, -1 if the file could not be created.
+int export_ics(const char* path, int day) {
+    FILE* out = fopen(path, "w");
+    if (out == NULL) return -1;
+    
+    int year, month, date;
+    civil_from_days(day, &year, &month, &date);
+    char stamp[32], value[128];
+    time_t now = time(NULL);
+    struct tm utc;
+    gmtime_r(&now, &utc);
+    strftime(stamp, sizeof(stamp), "%Y%m%dT%H%M%SZ", &utc);
+    
+    flockfile(out);
+    fputs("BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//Dynamic Event Scheduler//EN\r\n", out);
+    const ScheduleSnapshot* snapshot = snapshot_acquire();
+    int count = snapshot != NULL ? snapshot->num_events : 0;
+    for (int i = 0; i < count; i++) {
+        const Event* event = &snapshot->events[i];
+        int start = event_start_minutes(event), end = event_end_minutes(event);
+        int end_day = day + end / (24 * 60);
+        int end_year, end_month, end_date;
+        civil_from_days(end_day, &end_year, &end_month, &end_date);
+        
+        fputs("BEGIN:VEVENT\r\n", out);
+        fprintf(out, "UID:%d@dynamic-event-scheduler\r\nDTSTAMP:%s\r\n", event->id, stamp);
+        fprintf(out, "DTSTART:%04d%02d%02dT%02d%02d00\r\n", year, month, date, start / 60, start % 60);
+        fprintf(out, "DTEND:%04d%02d%02dT%02d%02d00\r\n", end_year, end_month, end_date, end % (24 * 60) / 60,
+                end % 60);
+        ics_escape(event->name, value, sizeof(value));
+        ics_write_line(out, "SUMMARY", value);
+        fprintf(out, "PRIORITY:%d\r\nSTATUS:%s\r\n", priority_to_ics(event->priority),
+                event->scheduled ? "CONFIRMED" : "TENTATIVE");
+        if (event->room >= 0 && event->room < num_rooms) {
+            ics_escape(rooms[event->room].name, value, sizeof(value));
+            ics_write_line(out, "LOCATION", value);
+        }
+        fputs("END:VEVENT\r\n", out);
+    }
+    snapshot_release();
+    fputs("END:VCALENDAR\r\n", out);
+    funlockfile(out);
+    fclose(out);
+    return count;
+}
+
+// "20240115" -> day number; "0", "" or unreadable -> ICS_NO_DAY
+int parse_ics_day_argument(const char* text) {
+    IcsTime parsed;
+    return text != NULL && strlen(text) >= 8 && parse_ics_time(text, &parsed) ? parsed.day : ICS_NO_DAY;
+}
+
+void print_ics_import(const char* path, const IcsImportStats* stats, double elapsed_ms) {
+    printf("Imported %lld of %lld VEVENTs from %s in %.1f ms", stats->imported, stats->vevents, path, elapsed_ms);
+    printf(" (skipped: %lld all-day, %lld on other days, %lld with no valid start or end, %lld over capacity)\n",
+           stats->all_day, stats->other_day, stats->invalid, stats->rejected);
+}
+
+// Import of the web frontend's saved state. script.js keeps its events in
+// localStorage as eventScheduler_events (a JSON array) and
+// eventScheduler_nextId. Accepted input is either that array on its own,
+// or an object holding both keys, as a storage dump writes it. The key
+// values may be the JSON itself or, as localStorage stores them, strings
+// that contain the JSON.
+//
+// The reader makes one pass over the file with one byte of lookahead. An
+// embedded string is unescaped as it is read, and the array inside it is
+// parsed in the same pass. Nothing is buffered but the current event.
+// color, degree, endTime and scheduled are derived state and are
+// recomputed by the rebuild that ends the batch.
+#define JSON_NO_BYTE (-2)
+
+typedef struct {
+    FILE* in;
+    bool embedded;             // Reading JSON inside a JSON string: unescape, '"' ends it
+    bool embedded_ended;
+    int peeked;                // JSON_NO_BYTE if none
+    long long offset;          // Bytes read, for error messages
+} JsonReader;
+
+typedef struct {
+    long long events;          // Objects in eventScheduler_events
+    long long imported;
+    long long other_day;       // Skipped: on a different date than requested
+    long long duplicate;       // Skipped: id already in use
+    long long invalid;         // Skipped: bad id, or missing or unreadable startTime or duration
+    long long rejected;        // The event store was full
+    long long browser_scheduled;  // Marked scheduled by the browser
+    int next_id;               // eventScheduler_nextId, 0 if absent
+} BrowserImportStats;
+
+int json_raw_get(JsonReader* reader) {
+    int c = getc_unlocked(reader->in);
+    if (c != EOF) reader->offset++;
+    return c;
+}
+
+int json_hex4(JsonReader* reader, int (*get)(JsonReader*)) {
+    int value = 0;
+    for (int k = 0; k < 4; k++) {
+        int c = get(reader);
+        int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+                    c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+        if (digit < 0) return -1;
+        value = value * 16 + digit;
+    }
+    return value;
+}
+
+// Next byte of the JSON text, after the outer string's escaping is undone
+int json_get(JsonReader* reader) {
+    if (reader->peeked != JSON_NO_BYTE) {
+        int c = reader->peeked;
+        reader->peeked = JSON_NO_BYTE;
+        return c;
+    }
+    if (!reader->embedded) return json_raw_get(reader);
+    if (reader->embedded_ended) return EOF;
+    
+    int c = json_raw_get(reader);
+    if (c == '"' || c == EOF) {
+        reader->embedded_ended = true;
+        return EOF;
+    }
+    if (c != '\\') return c;
+    c = json_raw_get(reader);
+    switch (c) {
+        case 'n': case 'r': case 't': case 'b': case 'f':
+            return ' ';
+        case 'u': {
+            int code = json_hex4(reader, json_raw_get);
+            return code >= 0 && code < 0x80 ? code : '?';
+        }
+        default:
+            return c;          // \" \\ \/
+    }
+}
+
+int json_peek(JsonReader* reader) {
+    if (reader->peeked == JSON_NO_BYTE) reader->peeked = json_get(reader);
+    return reader->peeked;
+}
+
+// Peek the next byte that is not whitespace
+int json_peek_token(JsonReader* reader) {
+    int c = json_peek(reader);
+    while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        reader->peeked = JSON_NO_BYTE;
+        c = json_peek(reader);
+    }
+    return c;
+}
+
+bool json_expect(JsonReader* reader, int expected) {
+    if (json_peek_token(reader) != expected) return false;
+    reader->peeked = JSON_NO_BYTE;
+    return true;
+}
+
+// Read a string into out (truncated to cap - 1 bytes, \u escapes as UTF-8)
+bool json_read_string(JsonReader* reader, char* out, size_t cap) {
+    if (!json_expect(reader, '"')) return false;
+    size_t len = 0;
+    for (;;) {
+        int c = json_get(reader);
+        if (c == EOF) return false;
+        if (c == '"') break;
+        if (c == '\\') {
+            c = json_get(reader);
+            if (c == 'u') {
+                int code = json_hex4(reader, json_get);
+                if (code < 0) return false;
+                char utf8[3];
+                int n = 0;
+                if (code < 0x80) {
+                    utf8[n++] = (char)code;
+                } else if (code < 0x800) {
+                    utf8[n++] = (char)(0xC0 | code >> 6);
+                    utf8[n++] = (char)(0x80 | (code & 0x3F));
+                } else {
+                    utf8[n++] = (char)(0xE0 | code >> 12);
+                    utf8[n++] = (char)(0x80 | (code >> 6 & 0x3F));
+                    utf8[n++] = (char)(0x80 | (code & 0x3F));
+                }
+                if (len + n < cap) {
+                    memcpy(out + len, utf8, n);
+                    len += n;
+                }
+                continue;
+            }
+            c = c == 'n' || c == 'r' || c == 't' || c == 'b' || c == 'f' ? ' ' : c;
+        }
+        if (len < cap - 1) out[len++] = (char)c;
+    }
+    out[len] = '\0';
+    return true;
+}
+
+// A number, a literal (true, false, null) or the text of a string, as one
+// token of at most cap - 1 bytes
+bool json_scalar_byte(int c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '-' || c == '+' ||
+           c == '.';
+}
+
+bool json_read_scalar(JsonReader* reader, char* out, size_t cap) {
+    if (json_peek_token(reader) == '"') return json_read_string(reader, out, cap);
+    size_t len = 0;
+    for (int c = json_peek(reader); json_scalar_byte(c); c = json_peek(reader)) {
+        if (len < cap - 1) out[len++] = (char)c;
+        reader->peeked = JSON_NO_BYTE;
+    }
+    out[len] = '\0';
+    return len > 0;
+}
+
+// Skip one value of any type, nested containers included
+bool json_skip_value(JsonReader* reader) {
+    int depth = 0;
+    do {
+        int c = json_peek_token(reader);
+        if (c == '"') {
+            char ignored[1];
+            if (!json_read_string(reader, ignored, sizeof(ignored))) return false;
+        } else if (c == '{' || c == '[') {
+            reader->peeked = JSON_NO_BYTE;
+            depth++;
+        } else if (c == '}' || c == ']') {
+            reader->peeked = JSON_NO_BYTE;
+            depth--;
+        } else if (c == ',' || c == ':') {
+            reader->peeked = JSON_NO_BYTE;
+        } else {
+            char ignored[64];
+            if (!json_read_scalar(reader, ignored, sizeof(ignored))) return false;
+        }
+    } while (depth > 0);
+    return depth == 0;
+}
+
+// Parse the members of an object, calling member() with each key. member()
+// must consume the value.
+bool json_read_object(JsonReader* reader, bool (*member)(JsonReader*, const char*, void*), void* context) {
+    if (!json_expect(reader, '{')) return false;
+    if (json_expect(reader, '}')) return true;
+    do {
+        char key[64];
+        if (!json_read_string(reader, key, sizeof(key)) || !json_expect(reader, ':')) return false;
+        if (!member(reader, key, context)) return false;
+    } while (json_expect(reader, ','));
+    return json_expect(reader, '}');
+}
+
+// Whole number in [min, max], or `fallback` for anything else. Unlike atoi
+// this never overflows on hostile input.
+int json_parse_int(const char* value, long min, long max, int fallback) {
+    char* end;
+    errno = 0;
+    long number = strtol(value, &end, 10);
+    if (end == value || errno == ERANGE || number < min || number > max) return fallback;
+    return (int)number;
+}
+
+// Imported ids stay at or below this, leaving next_event_id room to count up
+#define BROWSER_MAX_ID (INT_MAX / 2)
+
+typedef struct {
+    int id;                    // 0 if absent, -1 if not in 0..BROWSER_MAX_ID
+    char name[50];
+    int start;                 // Minutes from midnight, -1 if unreadable
+    int duration;
+    int priority;
+    int day;                   // ICS_NO_DAY if absent
+    bool scheduled;
+} BrowserEvent;
+
+bool browser_event_member(JsonReader* reader, const char* key, void* context) {
+    BrowserEvent* event = (BrowserEvent*)context;
+    char value[64];
+    
+    if (strcmp(key, "name") == 0) {
+        if (json_peek_token(reader) == '"') return json_read_string(reader, event->name, sizeof(event->name));
+    } else if (strcmp(key, "id") == 0 || strcmp(key, "duration") == 0 || strcmp(key, "priority") == 0 ||
+               strcmp(key, "startTime") == 0 || strcmp(key, "date") == 0 || strcmp(key, "scheduled") == 0) {
+        if (!json_read_scalar(reader, value, sizeof(value))) return false;
+        int hour, minute, year, month, date;
+        if (strcmp(key, "id") == 0) {
+            event->id = json_parse_int(value, 0, BROWSER_MAX_ID, -1);
+        } else if (strcmp(key, "duration") == 0) {
+            event->duration = json_parse_int(value, 0, INT_MAX, 0);
+        } else if (strcmp(key, "priority") == 0) {
+            event->priority = json_parse_int(value, INT_MIN, INT_MAX, 0);
+        } else if (strcmp(key, "startTime") == 0) {
+            event->start = sscanf(value, "%d:%d", &hour, &minute) == 2 ? hour * 60 + minute : -1;
+        } else if (strcmp(key, "date") == 0) {
+            if (sscanf(value, "%d-%d-%d", &year, &month, &date) == 3) event->day = days_from_civil(year, month, date);
+        } else {
+            event->scheduled = strcmp(value, "true") == 0;
+        }
+        return true;
+    }
+    return json_skip_value(reader);   // color, degree, endTime and anything newer
+}
+
+void browser_commit_event(const BrowserEvent* event, int target_day, BrowserImportStats* stats) {
+    if (event->id < 0 || event->start < 0 || event->start >= 24 * 60 || event->duration <= 0) {
+        stats->invalid++;
+        return;
+    }
+    if (target_day != ICS_NO_DAY && event->day != target_day) {
+        stats->other_day++;
+        return;
+    }
+    if (event->id > 0 && find_event_index(event->id) != -1) {
+        stats->duplicate++;
+        return;
+    }
+    
+    char name[50];
+    strcpy(name, event->name[0] != '\0' ? event->name : "(no title)");
+    int priority = event->priority >= 1 && event->priority <= 5 ? event->priority : 3;
+    if (add_event_with_id(event->id, name, event->start / 60, event->start % 60,
+                          event->duration, priority) == -1) {
+        stats->rejected++;
+    } else {
+        stats->imported++;
+        if (event->id >= next_event_id) next_event_id = event->id + 1;
+    }
+}
+
+typedef struct {
+    int target_day;
+    BrowserImportStats* stats;
+} BrowserImport;
+
+bool browser_read_events(JsonReader* reader, BrowserImport* import) {
+    if (!json_expect(reader, '[')) return false;
+    if (json_expect(reader, ']')) return true;
+    do {
+        BrowserEvent event;
+        memset(&event, 0, sizeof(event));
+        event.start = -1;
+        event.day = ICS_NO_DAY;
+        if (!json_read_object(reader, browser_event_member, &event)) return false;
+        
+        import->stats->events++;
+        if (event.scheduled) import->stats->browser_scheduled++;
+        browser_commit_event(&event, import->target_day, import->stats);
+    } while (json_expect(reader, ','));
+    return json_expect(reader, ']');
+}
+
+// The value of a storage key: the JSON itself, or a string holding it
+bool browser_read_stored(JsonReader* reader, BrowserImport* import, bool is_events) {
+    bool embedded = json_peek_token(reader) == '"';
+    if (embedded) {
+        reader->peeked = JSON_NO_BYTE;
+        reader->embedded = true;
+        reader->embedded_ended = false;
+    }
+    
+    bool ok;
+    if (is_events) {
+        ok = browser_read_events(reader, import);
+    } else {
+        char value[32];
+        ok = json_read_scalar(reader, value, sizeof(value));
+        import->stats->next_id = json_parse_int(value, 0, BROWSER_MAX_ID + 1, 0);
+    }
+    
+    if (embedded) {
+        ok = ok && json_peek_token(reader) == EOF;
+        while (!reader->embedded_ended) json_get(reader);   // Drain to the closing quote on error
+        reader->embedded = false;
+        reader->peeked = JSON_NO_BYTE;
+    }
+    return ok;
+}
+
+bool browser_storage_member(JsonReader* reader, const char* key, void* context) {
+    BrowserImport* import = (BrowserImport*)context;
+    if (strcmp(key, "eventScheduler_events") == 0) return browser_read_stored(reader, import, true);
+    if (strcmp(key, "eventScheduler_nextId") == 0) return browser_read_stored(reader, import, false);
+    return json_skip_value(reader);   // eventScheduler_conflicts is rebuilt
+}
+
+// Load the frontend's events (every date for target_day ICS_NO_DAY) as one
+// batch, keeping their ids, and advance next_event_id past nextId. Returns
+// false if the file cannot be opened or is not valid JSON of that shape;
+// events read before a syntax error are kept. *error_offset is the byte
+// where reading stopped.
+bool import_browser_storage(const char* path, int target_day, BrowserImportStats* stats, long long* error_offset) {
+    FILE* in = fopen(path, "r");
+    *error_offset = -1;
+    if (in == NULL) return false;
+    
+    JsonReader reader = {in, false, false, JSON_NO_BYTE, 0};
+    BrowserImport import = {target_day, stats};
+    memset(stats, 0, sizeof(*stats));
+    
+    bool was_verbose = verbose_output;
+    verbose_output = false;
+    flockfile(in);
+    begin_batch();
+    bool ok = json_peek_token(&reader) == '[' ? browser_read_events(&reader, &import)
+                                              : json_read_object(&reader, browser_storage_member, &import);
+    ok = ok && json_peek_token(&reader) == EOF;
+    if (!ok) *error_offset = reader.offset;
+    if (stats->next_id > next_event_id) next_event_id = stats->next_id;
+    funlockfile(in);
+    fclose(in);
+    verbose_output = was_verbose;
+    end_batch();
+    return ok;
+}
+
+void print_browser_import(const char* path, const BrowserImportStats* stats, double elapsed_ms) {
+    int scheduled = 0;
+    for (int i = 0; i < num_events; i++) {
+        if (events[i].scheduled) scheduled++;
+    }
+    printf("Imported %lld of %lld browser events from %s in %.1f ms", stats->imported, stats->events, path,
+           elapsed_ms);
+    printf(" (skipped: %lld on other days, %lld duplicate ids, %lld invalid, %lld over capacity)\n",
+           stats->other_day, stats->duplicate, stats->invalid, stats->rejected);
+    printf("Browser had %lld scheduled; %d of %d events are scheduled now. Next id: %d\n",
+           stats->browser_scheduled, scheduled, num_events, (int)next_event_id);
+}
+
+// Mutations submitted by client threads to the single scheduler thread
+typedef enum {
+    MUTATION_ADD,
+    MUTATION_REMOVE,
+    MUTATION_SET_REQUIREMENTS,
+    MUTATION_UPDATE
+} MutationType;
+
+// Completion handle a client waits on; filled in after the batch commits
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t done_cond;
+    bool done;
+    int result;                  // New event id for adds, 1/0 success otherwise
+    unsigned long long version;  // First published snapshot containing the change
+} MutationFuture;
+
+typedef struct MutationRequest {
+    _Atomic(struct MutationRequest*) next;   // Intrusive MPSC link
+    MutationType type;
+    int event_id;
+    char name[50];
+    int start_hour;
+    int start_minute;
+    int duration_minutes;
+    int priority;
+    int attendees;
+    unsigned int required_features;
+    bool has_requirements;                   // Add carries requirements folded in from a later edit
+    bool cancelled;                          // Add and remove of the same event met in one batch
+    struct MutationRequest* merged_into;     // Superseded; takes its result from this request
+    MutationFuture future;
+} MutationRequest;
+
+// Intrusive lock-free multi-producer single-consumer queue (Vyukov).
+// Producers only do one atomic exchange; the scheduler thread owns tail.
+typedef struct {
+    _Atomic(MutationRequest*) head;
+    MutationRequest* tail;
+    MutationRequest stub;
+} MutationQueue;
+
+MutationQueue mutation_queue;
+sem_t mutation_signal;              // One post per push, wakes the scheduler thread
+pthread_t scheduler_thread;
+atomic_bool pipeline_running = false;
+long long pipeline_batches = 0;
+long long pipeline_mutations = 0;
+long long pipeline_coalesced = 0;   // Requests that never reached the event store
+int mutation_window_us = 0;         // How long a batch stays open after its first request
+
+void mutation_queue_init(MutationQueue* queue) {
+    atomic_store(&queue->stub.next, NULL);
+    atomic_store(&queue->head, &queue->stub);
+    queue->tail = &queue->stub;
+}
+
+void mutation_queue_push(MutationQueue* queue, MutationRequest* request) {
+    atomic_store(&request->next, NULL);
+    MutationRequest* previous = atomic_exchange(&queue->head, request);
+    atomic_store(&previous->next, request);
+}
+
+// Returns NULL when empty, or when a producer is between its exchange and
+// link; that producer's sem_post wakes the consumer again afterwards
+MutationRequest* mutation_queue_pop(MutationQueue* queue) {
+    MutationRequest* tail = queue->tail;
+    MutationRequest* next = atomic_load(&tail->next);
+    
+    if (tail == &queue->stub) {
+        if (next == NULL) return NULL;
+        queue->tail = next;
+        tail = next;
+        next = atomic_load(&next->next);
+    }
+    if (next != NULL) {
+        queue->tail = next;
+        return tail;
+    }
+    if (tail != atomic_load(&queue->head)) return NULL;
+    
+    mutation_queue_push(queue, &queue->stub);
+    next = atomic_load(&tail->next);
+    if (next != NULL) {
+        queue->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+// Finished requests are kept for reuse, so steady submission allocates nothing
+#define MUTATION_POOL_LIMIT 1024
+
+MutationRequest* free_mutations = NULL;      // Linked through merged_into
+int num_free_mutations = 0;
+pthread_mutex_t mutation_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+MutationRequest* new_mutation(MutationType type) {
+    pthread_mutex_lock(&mutation_pool_lock);
+    MutationRequest* request = free_mutations;
+    if (request != NULL) {
+        free_mutations = request->merged_into;
+        num_free_mutations--;
+    }
+    pthread_mutex_unlock(&mutation_pool_lock);
+    
+    if (request != NULL) memset(request, 0, sizeof(*request));
+    else request = (MutationRequest*)calloc(1, sizeof(MutationRequest));
+    request->type = type;
+    pthread_mutex_init(&request->future.lock, NULL);
+    pthread_cond_init(&request->future.done_cond, NULL);
+    return request;
+}
+
+void submit_mutation(MutationRequest* request) {
+    mutation_queue_push(&mutation_queue, request);
+    sem_post(&mutation_signal);
+}
+
+// Client API: each submit returns a request whose future is awaited with
+// mutation_wait(). Requests from one thread are applied in submit order.
+// An add's event id is reserved at submit (request->event_id), so later
+// edits to the new event can be submitted without waiting for it.
+MutationRequest* submit_add_event(const char* name, int start_hour, int start_minute,
+                                  int duration_minutes, int priority) {
+    MutationRequest* request = new_mutation(MUTATION_ADD);
+    request->event_id = atomic_fetch_add(&next_event_id, 1);
+    snprintf(request->name, sizeof(request->name), "%s", name);
+    request->start_hour = start_hour;
+    request->start_minute = start_minute;
+    request->duration_minutes = duration_minutes;
+    request->priority = priority;
+    submit_mutation(request);
+    return request;
+}
+
+MutationRequest* submit_remove_event(int event_id) {
+    MutationRequest* request = new_mutation(MUTATION_REMOVE);
+    request->event_id = event_id;
+    submit_mutation(request);
+    return request;
+}
+
+MutationRequest* submit_set_requirements(int event_id, int attendees, unsigned int required_features) {
+    MutationRequest* request = new_mutation(MUTATION_SET_REQUIREMENTS);
+    request->event_id = event_id;
+    request->attendees = attendees;
+    request->required_features = required_features;
+    submit_mutation(request);
+    return request;
+}
+
+MutationRequest* submit_update_event(int event_id, const char* name, int start_hour, int start_minute,
+                                     int duration_minutes, int priority) {
+    MutationRequest* request = new_mutation(MUTATION_UPDATE);
+    request->event_id = event_id;
+    snprintf(request->name, sizeof(request->name), "%s", name);
+    request->start_hour = start_hour;
+    request->start_minute = start_minute;
+    request->duration_minutes = duration_minutes;
+    request->priority = priority;
+    submit_mutation(request);
+    return request;
+}
+
+// Block until the request's batch has been applied and published, release
+// it and return its result. Optionally reports the snapshot version.
+int mutation_wait(MutationRequest* request, unsigned long long* version) {
+    pthread_mutex_lock(&request->future.lock);
+    while (!request->future.done) {
+        pthread_cond_wait(&request->future.done_cond, &request->future.lock);
+    }
+    pthread_mutex_unlock(&request->future.lock);
+    
+    int result = request->future.result;
+    if (version != NULL) *version = request->future.version;
+    pthread_mutex_destroy(&request->future.lock);
+    pthread_cond_destroy(&request->future.done_cond);
+    
+    pthread_mutex_lock(&mutation_pool_lock);
+    if (num_free_mutations < MUTATION_POOL_LIMIT) {
+        request->merged_into = free_mutations;
+        free_mutations = request;
+        num_free_mutations++;
+        request = NULL;
+    }
+    pthread_mutex_unlock(&mutation_pool_lock);
+    free(request);
+    return result;
+}
+
+void complete_mutation(MutationRequest* request, unsigned long long version) {
+    pthread_mutex_lock(&request->future.lock);
+    request->future.version = version;
+    request->future.done = true;
+    pthread_cond_signal(&request->future.done_cond);
+    pthread_mutex_unlock(&request->future.lock);
+}
+
+void apply_mutation(MutationRequest* request) {
+    switch (request->type) {
+        case MUTATION_ADD:
+            request->future.result = add_event_with_id(request->event_id, request->name, request->start_hour,
+                                                       request->start_minute, request->duration_minutes,
+                                                       request->priority);
+            if (request->future.result > 0 && request->has_requirements) {
+                set_event_requirements(request->event_id, request->attendees, request->required_features);
+            }
+            break;
+        case MUTATION_REMOVE:
+            request->future.result = remove_event(request->event_id) ? 1 : 0;
+            break;
+        case MUTATION_SET_REQUIREMENTS:
+            request->future.result = set_event_requirements(request->event_id, request->attendees,
+                                                            request->required_features) ? 1 : 0;
+            break;
+        case MUTATION_UPDATE:
+            request->future.result = update_event(request->event_id, request->name, request->start_hour,
+                                                  request->start_minute, request->duration_minutes,
+                                                  request->priority) ? 1 : 0;
+            break;
+    }
+}
+
+// Record a request that coalescing kept away from the event store
+void trace_mutation(const MutationRequest* request) {
+    double began = trace_begin();
+    switch (request->type) {
+        case MUTATION_ADD:
+            trace_end(began, TRACE_ADD, request->event_id, request->start_hour * 60 + request->start_minute,
+                      request->duration_minutes, request->priority, request->name);
+            break;
+        case MUTATION_REMOVE:
+            trace_end(began, TRACE_REMOVE, request->event_id, 0, 0, 0, NULL);
+            break;
+        case MUTATION_SET_REQUIREMENTS:
+            trace_end(began, TRACE_REQUIREMENTS, request->event_id, request->attendees,
+                      (int)request->required_features, 0, NULL);
+            break;
+        case MUTATION_UPDATE:
+            trace_end(began, TRACE_UPDATE, request->event_id, request->start_hour * 60 + request->start_minute,
+                      request->duration_minutes, request->priority, request->name);
+            break;
+    }
+}
+
+// Reduce a batch to its net effect per event id, in submit order:
+//   add, remove of the same event   -> both cancelled
+//   add, update or requirements     -> folded into the add
+//   update, update                  -> only the last one (same for requirements)
+//   update or requirements, remove  -> only the remove
+// Updates and requirement edits touch different fields, so each kind is
+// coalesced on its own. Returns how many requests still have to be applied.
+typedef struct {
+    int event_id;
+    MutationRequest* add;            // Pending add of this event
+    MutationRequest* update;         // Latest pending update
+    MutationRequest* requirements;   // Latest pending requirement edit
+} PendingMutations;
+
+int coalesce_mutations(MutationRequest* batch[], int count) {
+    static PendingMutations pending[2 * MAX_MUTATION_BATCH];   // Open addressing by event id
+    static bool used[2 * MAX_MUTATION_BATCH];
+    const int slots = 2 * MAX_MUTATION_BATCH;
+    int remaining = count;
+    
+    memset(used, 0, sizeof(used));
+    for (int k = 0; k < count; k++) {
+        MutationRequest* request = batch[k];
+        int slot = (int)(((unsigned int)request->event_id * 2654435761u) % (unsigned int)slots);
+        while (used[slot] && pending[slot].event_id != request->event_id) {
+            slot = (slot + 1) % slots;
+        }
+        PendingMutations* entry = &pending[slot];
+        if (!used[slot]) {
+            used[slot] = true;
+            entry->event_id = request->event_id;
+            entry->add = entry->update = entry->requirements = NULL;
+        }
+        
+        switch (request->type) {
+            case MUTATION_ADD:
+                entry->add = request;
+                break;
+            case MUTATION_REMOVE:
+                if (entry->update != NULL) {
+                    entry->update->merged_into = request;
+                    remaining--;
+                }
+                if (entry->requirements != NULL) {
+                    entry->requirements->merged_into = request;
+                    remaining--;
+                }
+                if (entry->add != NULL) {
+                    entry->add->cancelled = true;
+                    request->cancelled = true;
+                    remaining -= 2;
+                }
+                entry->add = entry->update = entry->requirements = NULL;
+                break;
+            case MUTATION_UPDATE:
+                if (entry->add != NULL) {
+                    snprintf(entry->add->name, sizeof(entry->add->name), "%s", request->name);
+                    entry->add->start_hour = request->start_hour;
+                    entry->add->start_minute = request->start_minute;
+                    entry->add->duration_minutes = request->duration_minutes;
+                    entry->add->priority = request->priority;
+                    request->merged_into = entry->add;
+                    remaining--;
+                } else {
+                    if (entry->update != NULL) {
+                        entry->update->merged_into = request;
+                        remaining--;
+                    }
+                    entry->update = request;
+                }
+                break;
+            case MUTATION_SET_REQUIREMENTS:
+                if (entry->add != NULL) {
+                    entry->add->attendees = request->attendees;
+                    entry->add->required_features = request->required_features;
+                    entry->add->has_requirements = true;
+                    request->merged_into = entry->add;
+                    remaining--;
+                } else {
+                    if (entry->requirements != NULL) {
+                        entry->requirements->merged_into = request;
+                        remaining--;
+                    }
+                    entry->requirements = request;
+                }
+                break;
+        }
+    }
+    return remaining;
+}
+
+// Result a request would have had on its own
+int coalesced_result(MutationRequest* request) {
+    if (request->cancelled) {
+        return request->type == MUTATION_ADD ? request->event_id : 1;
+    }
+    if (request->merged_into == NULL) return request->future.result;
+    
+    MutationRequest* final = request->merged_into;
+    while (final->merged_into != NULL) final = final->merged_into;
+    int result = coalesced_result(final);
+    return final->type == MUTATION_ADD ? (result > 0 ? 1 : 0) : result;
+}
+
+// Scheduler thread: the only writer while the pipeline runs. Drains
+// whatever has queued up (waiting up to mutation_window_us for more),
+// coalesces it, applies the net effect as one batch (one graph rebuild
+// and one reschedule), publishes the snapshot, then completes every
+// future. A batch that cancels out entirely is not applied at all.
+void* scheduler_thread_main(void* arg) {
+    static MutationRequest* batch[MAX_MUTATION_BATCH];
+    // Requests popped minus posts consumed. Posts and pops drift apart: a
+    // pop can take a request whose post is still to come, and a pop can
+    // come back empty while the push it was posted for is still linking
+    // its node. A negative balance means queued requests lost their wake
+    // up, so it is handed back to the semaphore.
+    long long post_balance = 0;
+    (void)arg;
+    
+    while (true) {
+        // Once stopping, keep draining without waiting until the queue is empty
+        if (atomic_load(&pipeline_running)) {
+            if (sem_wait(&mutation_signal) == 0) post_balance--;
+        }
+        
+        int count = 0;
+        MutationRequest* request;
+        double deadline = now_ms() + mutation_window_us / 1000.0;
+        while (true) {
+            while (count < MAX_MUTATION_BATCH && (request = mutation_queue_pop(&mutation_queue)) != NULL) {
+                batch[count++] = request;
+            }
+            double wait_ms = deadline - now_ms();
+            if (count == 0 || count == MAX_MUTATION_BATCH || wait_ms <= 0 || !atomic_load(&pipeline_running)) {
+                break;
+            }
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            long long nanos = until.tv_nsec + (long long)(wait_ms * 1e6);
+            until.tv_sec += (time_t)(nanos / 1000000000LL);
+            until.tv_nsec = (long)(nanos % 1000000000LL);
+            if (sem_timedwait(&mutation_signal, &until) == 0) post_balance--;
+        }
+        post_balance += count;
+        for (; post_balance < 0; post_balance++) {
+            sem_post(&mutation_signal);
+        }
+        if (count == 0) {
+            if (!atomic_load(&pipeline_running)) break;
+            continue;
+        }
+        
+        clock_tick();
+        int remaining = coalesce_mutations(batch, count);
+        // Coalesced requests are still traced at their place in submit order,
+        // so a replay makes every call the clients made and ends in the same state
+        if (remaining > 0) begin_batch();
+        for (int k = 0; k < count; k++) {
+            if (!batch[k]->cancelled && batch[k]->merged_into == NULL) {
+                apply_mutation(batch[k]);
+            } else {
+                trace_mutation(batch[k]);
+            }
+        }
+        if (remaining > 0) end_batch();
+        
+        pipeline_batches++;
+        pipeline_mutations += count;
+        pipeline_coalesced += count - remaining;
+        for (int k = 0; k < count; k++) {
+            batch[k]->future.result = coalesced_result(batch[k]);
+        }
+        for (int k = 0; k < count; k++) {
+            complete_mutation(batch[k], snapshot_version);
+        }
+    }
+    return NULL;
+}
+
+// From here until stop_mutation_pipeline(), only the scheduler thread may
+// touch the live event store; everyone else submits or reads snapshots
+void start_mutation_pipeline() {
+    mutation_queue_init(&mutation_queue);
+    sem_init(&mutation_signal, 0, 0);
+    pipeline_batches = 0;
+    pipeline_mutations = 0;
+    pipeline_coalesced = 0;
+    atomic_store(&pipeline_running, true);
+    pthread_create(&scheduler_thread, NULL, scheduler_thread_main, NULL);
+}
+
+// Applies everything already submitted, then joins the scheduler thread
+void stop_mutation_pipeline() {
+    atomic_store(&pipeline_running, false);
+    sem_post(&mutation_signal);
+    pthread_join(scheduler_thread, NULL);
+    sem_destroy(&mutation_signal);
+}
+
+// Local RPC server: ./scheduler --serve [socket path]
+// One poll() loop is the engine's only writer. Each round it reads every
+// ready connection, admits writes into the interactive or bulk lane, and
+// answers reads from the published snapshot. It then applies every
+// interactive write and a bounded share of bulk writes as one batch: one
+// reschedule and one snapshot publish. Keeping bulk batches small keeps
+// rounds short, which is what bounds interactive latency. A full lane
+// refuses writes with OVERLOADED and a retry-after estimate.
+// Wire format: sched_protocol.h.
+#define MAX_RPC_CONNECTIONS 256
+#define RPC_INPUT_BUFFER 65536
+#define RPC_OUTPUT_HIGH_WATER (4 << 20)   // Stop reading from clients that do not drain responses
+#define RPC_MAX_PENDING 4096              // Write responses waiting for their commit
+#define RPC_LANE_CAPACITY 1024            // Queued writes per lane before OVERLOADED
+#define RPC_BULK_PER_ROUND 64             // Bulk writes applied per round
+
+enum { RPC_LANE_INTERACTIVE, RPC_LANE_BULK, RPC_LANES };
+
+typedef struct {
+    int fd;
+    unsigned char* input;
+    size_t input_len;
+    unsigned char* output;
+    size_t output_len;
+    size_t output_sent;
+    size_t output_cap;
+    size_t output_hold;   // Output from here on waits for a queued write's response
+    int queued_writes;
+    int lane;             // Lane of the queued writes, so they apply in order
+    bool eof;             // Peer shut down its sending side; buffered frames are still answered
+    bool closing;         // Read error or protocol violation: read no more
+} RpcConnection;
+
+// A write response whose version (and scheduled flag) is only known once
+// the batch commits
+typedef struct {
+    int connection;
+    size_t offset;        // Of the SchedMutationResponse in the output buffer
+    int event_id;         // Report scheduled status for this event, 0 = none
+} RpcPendingVersion;
+
+// A write admitted to a lane but not yet applied. Its response frame is
+// already reserved in the connection's output, keeping responses in order.
+typedef struct {
+    int connection;
+    size_t offset;        // Of the reserved SchedMutationResponse
+    SchedFrameHeader header;
+    union {
+        SchedAddRequest add;
+        SchedIdRequest id;
+        SchedUpdateRequest update;
+    } request;
+} RpcQueuedWrite;
+
+typedef struct {
+    RpcQueuedWrite entries[RPC_LANE_CAPACITY];
+    int head;
+    int count;
+    long long admitted;
+    long long refused;
+} RpcLane;
+
+RpcConnection rpc_connections[MAX_RPC_CONNECTIONS];
+RpcLane rpc_lanes[RPC_LANES];
+double rpc_round_ms = 1.0;   // Moving average, for retry-after estimates
+int rpc_num_connections = 0;
+RpcPendingVersion rpc_pending[RPC_MAX_PENDING];
+int rpc_num_pending = 0;
+bool rpc_batch_open = false;
+long long rpc_requests = 0;
+long long rpc_commits = 0;
+volatile sig_atomic_t rpc_stop = 0;
+
+void rpc_handle_signal(int signal_number) {
+    (void)signal_number;
+    rpc_stop = 1;
+}
+
+// Append one response frame, returns the payload offset in the output buffer.
+// A NULL payload reserves the space for the caller to fill.
+size_t rpc_reply(RpcConnection* connection, uint32_t tag, uint8_t op, uint8_t status,
+                 const void* payload, size_t payload_len) {
+    size_t frame_len = sizeof(SchedFrameHeader) + payload_len;
+    if (connection->output_len + frame_len > connection->output_cap) {
+        size_t cap = connection->output_cap > 0 ? connection->output_cap : 4096;
+        while (cap < connection->output_len + frame_len) cap *= 2;
+        connection->output = (unsigned char*)realloc(connection->output, cap);
+        connection->output_cap = cap;
+    }
+    
+    SchedFrameHeader header;
+    header.length = (uint32_t)frame_len;
+    header.tag = tag;
+    header.op = op;
+    header.status = status;
+    header.flags = 0;
+    memcpy(connection->output + connection->output_len, &header, sizeof(header));
+    if (payload != NULL && payload_len > 0) {
+        memcpy(connection->output + connection->output_len + sizeof(header), payload, payload_len);
+    }
+    connection->output_len += frame_len;
+    return connection->output_len - payload_len;
+}
+
+// Fill in a reserved mutation response
+void rpc_resolve(RpcConnection* connection, size_t offset, uint8_t status, const SchedMutationResponse* response) {
+    connection->output[offset - sizeof(SchedFrameHeader) + offsetof(SchedFrameHeader, status)] = status;
+    memcpy(connection->output + offset, response, sizeof(*response));
+}
+
+// Commit the open batch and fill in the versions it produced
+void rpc_commit() {
+    if (!rpc_batch_open) return;
+    end_batch();
+    rpc_batch_open = false;
+    rpc_commits++;
+    
+    for (int p = 0; p < rpc_num_pending; p++) {
+        RpcPendingVersion* pending = &rpc_pending[p];
+        unsigned char* out = rpc_connections[pending->connection].output + pending->offset;
+        SchedMutationResponse response;
+        memcpy(&response, out, sizeof(response));
+        response.version = snapshot_version;
+        if (pending->event_id > 0) {
+            int index = find_event_index(pending->event_id);
+            response.scheduled = index >= 0 && events[index].scheduled;
+        }
+        memcpy(out, &response, sizeof(response));
+    }
+    rpc_num_pending = 0;
+}
+
+void rpc_begin_write() {
+    if (rpc_num_pending == RPC_MAX_PENDING) rpc_commit();
+    if (!rpc_batch_open) {
+        begin_batch();
+        rpc_batch_open = true;
+    }
+}
+
+void rpc_defer_version(int connection, size_t offset, int event_id) {
+    rpc_pending[rpc_num_pending].connection = connection;
+    rpc_pending[rpc_num_pending].offset = offset;
+    rpc_pending[rpc_num_pending].event_id = event_id;
+    rpc_num_pending++;
+}
+
+bool rpc_valid_add(const SchedAddRequest* request) {
+    return request->start_minute >= 0 && request->start_minute < 24 * 60 &&
+           request->duration_minutes > 0 && request->start_minute + request->duration_minutes <= 24 * 60 &&
+           request->priority >= 1 && request->priority <= 5;
+}
+
+void rpc_apply_add(int c, size_t offset, const SchedAddRequest* request, bool try_only) {
+    RpcConnection* connection = &rpc_connections[c];
+    SchedMutationResponse response = {0, 0, 0};
+    
+    if (!rpc_valid_add(request)) {
+        rpc_resolve(connection, offset, SCHED_STATUS_INVALID, &response);
+        return;
+    }
+    if (try_only) {
+        // Check against the committed schedule, not a half-applied batch
+        rpc_commit();
+        const ScheduleSnapshot* snapshot = atomic_load(&published_snapshot);
+        if (sorted_intervals_overlap(snapshot->busy_start, snapshot->busy_max_end, snapshot->num_busy,
+                                     request->start_minute, request->start_minute + request->duration_minutes)) {
+            response.version = snapshot_version;
+            rpc_resolve(connection, offset, SCHED_STATUS_BUSY, &response);
+            return;
+        }
+    }
+    if (num_events >= MAX_EVENTS) {
+        response.version = snapshot_version;
+        rpc_resolve(connection, offset, SCHED_STATUS_FULL, &response);
+        return;
+    }
+    
+    char name[50];
+    memcpy(name, request->name, sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    
+    rpc_begin_write();
+    response.event_id = add_event(name, request->start_minute / 60, request->start_minute % 60,
+                                  request->duration_minutes, request->priority);
+    rpc_resolve(connection, offset, SCHED_STATUS_OK, &response);
+    rpc_defer_version(c, offset, response.event_id);
+}
+
+void rpc_apply_update(int c, size_t offset, const SchedUpdateRequest* request) {
+    RpcConnection* connection = &rpc_connections[c];
+    SchedMutationResponse response = {snapshot_version, request->event_id, 0};
+    
+    if (!rpc_valid_add(&request->event)) {
+        rpc_resolve(connection, offset, SCHED_STATUS_INVALID, &response);
+        return;
+    }
+    
+    char name[50];
+    memcpy(name, request->event.name, sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    
+    rpc_begin_write();
+    bool updated = update_event(request->event_id, name, request->event.start_minute / 60,
+                                request->event.start_minute % 60, request->event.duration_minutes,
+                                request->event.priority);
+    rpc_resolve(connection, offset, updated ? SCHED_STATUS_OK : SCHED_STATUS_NOT_FOUND, &response);
+    if (updated) rpc_defer_version(c, offset, request->event_id);
+}
+
+void rpc_apply_write(const RpcQueuedWrite* write) {
+    RpcConnection* connection = &rpc_connections[write->connection];
+    connection->queued_writes--;
+    
+    if (write->header.op == SCHED_OP_REMOVE) {
+        SchedMutationResponse response = {snapshot_version, write->request.id.event_id, 0};
+        rpc_begin_write();
+        bool removed = remove_event(write->request.id.event_id);
+        rpc_resolve(connection, write->offset, removed ? SCHED_STATUS_OK : SCHED_STATUS_NOT_FOUND, &response);
+        if (removed) rpc_defer_version(write->connection, write->offset, 0);
+    } else if (write->header.op == SCHED_OP_UPDATE) {
+        rpc_apply_update(write->connection, write->offset, &write->request.update);
+    } else {
+        rpc_apply_add(write->connection, write->offset, &write->request.add, write->header.op == SCHED_OP_TRY_ADD);
+    }
+}
+
+// Expected wait before a lane has room again
+uint32_t rpc_retry_after_ms(int lane) {
+    int per_round = lane == RPC_LANE_BULK ? RPC_BULK_PER_ROUND : RPC_LANE_CAPACITY;
+    double rounds = (double)rpc_lanes[lane].count / per_round;
+    double wait = (rounds + 1.0) * rpc_round_ms;
+    return wait < 1.0 ? 1 : (uint32_t)(wait + 0.5);
+}
+
+// Queue a write behind the connection's earlier ones, or refuse it if its
+// lane is full
+void rpc_admit_write(int c, const SchedFrameHeader* header, const unsigned char* payload, size_t payload_len) {
+    RpcConnection* connection = &rpc_connections[c];
+    int lane = (header->flags & SCHED_FLAG_BULK) ? RPC_LANE_BULK : RPC_LANE_INTERACTIVE;
+    if (connection->queued_writes > 0) lane = connection->lane;
+    RpcLane* queue = &rpc_lanes[lane];
+    
+    if (queue->count == RPC_LANE_CAPACITY) {
+        SchedRetryAfter retry = {rpc_retry_after_ms(lane), (uint32_t)queue->count};
+        rpc_reply(connection, header->tag, header->op, SCHED_STATUS_OVERLOADED, &retry, sizeof(retry));
+        queue->refused++;
+        return;
+    }
+    
+    RpcQueuedWrite* write = &queue->entries[(queue->head + queue->count) % RPC_LANE_CAPACITY];
+    SchedMutationResponse placeholder = {0, 0, 0};
+    write->connection = c;
+    write->header = *header;
+    memcpy(&write->request, payload, payload_len);
+    write->offset = rpc_reply(connection, header->tag, header->op, SCHED_STATUS_OK, &placeholder, sizeof(placeholder));
+    queue->count++;
+    queue->admitted++;
+    connection->queued_writes++;
+    connection->lane = lane;
+}
+
+// Apply every interactive write, then at most RPC_BULK_PER_ROUND bulk ones
+void rpc_drain_lanes() {
+    int budget[RPC_LANES] = {RPC_LANE_CAPACITY, RPC_BULK_PER_ROUND};
+    for (int lane = 0; lane < RPC_LANES; lane++) {
+        RpcLane* queue = &rpc_lanes[lane];
+        for (; queue->count > 0 && budget[lane] > 0; budget[lane]--) {
+            rpc_apply_write(&queue->entries[queue->head]);
+            queue->head = (queue->head + 1) % RPC_LANE_CAPACITY;
+            queue->count--;
+        }
+    }
+}
+
+// Output may only be sent up to the first response still waiting in a lane
+void rpc_update_holds() {
+    for (int c = 0; c < rpc_num_connections; c++) {
+        rpc_connections[c].output_hold = SIZE_MAX;
+    }
+    for (int lane = 0; lane < RPC_LANES; lane++) {
+        RpcLane* queue = &rpc_lanes[lane];
+        for (int k = 0; k < queue->count; k++) {
+            const RpcQueuedWrite* write = &queue->entries[(queue->head + k) % RPC_LANE_CAPACITY];
+            RpcConnection* connection = &rpc_connections[write->connection];
+            size_t frame = write->offset - sizeof(SchedFrameHeader);
+            if (frame < connection->output_hold) connection->output_hold = frame;
+        }
+    }
+}
+
+void rpc_handle_delta(RpcConnection* connection, const SchedFrameHeader* header, uint64_t since_version) {
+    static int ids[DELTA_LOG_CAPACITY];
+    static bool removed[DELTA_LOG_CAPACITY];
+    static SchedEventRecord records[DELTA_LOG_CAPACITY];
+    SchedListHeader list = {snapshot_version, 0, 0};
+    
+    int changed = schedule_changes_since(since_version, ids, removed);
+    if (changed < 0 || changed > MAX_EVENTS) {
+        // Too far behind, or more changes than a full list: resend everything
+        list.full = 1;
+        for (int i = 0; i < num_events; i++) {
+            event_record(&events[i], &records[list.count++]);
+        }
+    } else {
+        for (int k = 0; k < changed; k++) {
+            int index = removed[k] ? -1 : find_event_index(ids[k]);
+            if (index >= 0) {
+                event_record(&events[index], &records[list.count]);
+            } else {
+                memset(&records[list.count], 0, sizeof(SchedEventRecord));
+                records[list.count].event_id = ids[k];
+                records[list.count].removed = 1;
+            }
+            list.count++;
+        }
+    }
+    
+    size_t offset = rpc_reply(connection, header->tag, header->op, SCHED_STATUS_OK, NULL,
+                              sizeof(list) + (size_t)list.count * sizeof(SchedEventRecord));
+    memcpy(connection->output + offset, &list, sizeof(list));
+    memcpy(connection->output + offset + sizeof(list), records, (size_t)list.count * sizeof(SchedEventRecord));
+}
+
+void rpc_handle_frame(int c, const SchedFrameHeader* header, const unsigned char* payload, size_t payload_len) {
+    RpcConnection* connection = &rpc_connections[c];
+    rpc_requests++;
+    
+    switch (header->op) {
+        case SCHED_OP_ADD:
+        case SCHED_OP_TRY_ADD:
+            if (payload_len < sizeof(SchedAddRequest)) break;
+            rpc_admit_write(c, header, payload, sizeof(SchedAddRequest));
+            return;
+        case SCHED_OP_REMOVE:
+            if (payload_len < sizeof(SchedIdRequest)) break;
+            rpc_admit_write(c, header, payload, sizeof(SchedIdRequest));
+            return;
+        case SCHED_OP_UPDATE:
+            if (payload_len < sizeof(SchedUpdateRequest)) break;
+            rpc_admit_write(c, header, payload, sizeof(SchedUpdateRequest));
+            return;
+        case SCHED_OP_LOOKUP: {
+            SchedIdRequest request;
+            if (payload_len < sizeof(request)) break;
+            memcpy(&request, payload, sizeof(request));
+            
+            double began = trace_begin();
+            const ScheduleSnapshot* snapshot = atomic_load(&published_snapshot);
+            const Event* event = snapshot_find_event(snapshot, request.event_id);
+            trace_end(began, TRACE_LOOKUP, request.event_id, 0, 0, 0, NULL);
+            unsigned char body[sizeof(SchedListHeader) + sizeof(SchedEventRecord)];
+            SchedListHeader list = {snapshot->version, 0, 0};
+            if (event != NULL) {
+                SchedEventRecord record;
+                event_record(event, &record);
+                memcpy(body + sizeof(list), &record, sizeof(record));
+                list.count = 1;
+            }
+            memcpy(body, &list, sizeof(list));
+            rpc_reply(connection, header->tag, header->op, event != NULL ? SCHED_STATUS_OK : SCHED_STATUS_NOT_FOUND,
+                      body, sizeof(list) + (size_t)list.count * sizeof(SchedEventRecord));
+            return;
+        }
+        case SCHED_OP_FREE_SLOTS: {
+            SchedSlotsRequest request;
+            if (payload_len < sizeof(request)) break;
+            memcpy(&request, payload, sizeof(request));
+            if (request.duration_minutes <= 0 || request.duration_minutes > 24 * 60) break;
+            
+            double began = trace_begin();
+            const ScheduleSnapshot* snapshot = atomic_load(&published_snapshot);
+            int starts[MAX_TIME_SLOTS];
+            unsigned char body[sizeof(SchedListHeader) + sizeof(starts)];
+            SchedListHeader list = {snapshot->version, 0, 0};
+            list.count = snapshot_find_free_slots(snapshot, request.duration_minutes, starts, MAX_TIME_SLOTS);
+            trace_end(began, TRACE_FREE_SLOTS, request.duration_minutes, 0, 0, 0, NULL);
+            for (int k = 0; k < list.count; k++) {
+                int32_t start = starts[k];
+                memcpy(body + sizeof(list) + k * sizeof(int32_t), &start, sizeof(start));
+            }
+            memcpy(body, &list, sizeof(list));
+            rpc_reply(connection, header->tag, header->op, SCHED_STATUS_OK, body,
+                      sizeof(list) + (size_t)list.count * sizeof(int32_t));
+            return;
+        }
+        case SCHED_OP_DELTA: {
+            SchedDeltaRequest request;
+            if (payload_len < sizeof(request)) break;
+            memcpy(&request, payload, sizeof(request));
+            
+            rpc_commit();
+            rpc_handle_delta(connection, header, request.since_version);
+            return;
+        }
+        default:
+            rpc_reply(connection, header->tag, header->op, SCHED_STATUS_BAD_OP, NULL, 0);
+            return;
+    }
+    rpc_reply(connection, header->tag, header->op, SCHED_STATUS_INVALID, NULL, 0);
+}
+
+void rpc_read(RpcConnection* connection) {
+    while (connection->input_len < RPC_INPUT_BUFFER) {
+        ssize_t n = read(connection->fd, connection->input + connection->input_len,
+                         RPC_INPUT_BUFFER - connection->input_len);
+        if (n > 0) {
+            connection->input_len += (size_t)n;
+        } else {
+            if (n == 0) {
+                connection->eof = true;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                connection->closing = true;
+            }
+            if (n == 0 || errno != EINTR) return;
+        }
+    }
+}
+
+void rpc_process_input(int c) {
+    RpcConnection* connection = &rpc_connections[c];
+    size_t offset = 0;
+    
+    while (connection->input_len - offset >= sizeof(SchedFrameHeader)) {
+        SchedFrameHeader header;
+        memcpy(&header, connection->input + offset, sizeof(header));
+        if (header.length < sizeof(header) || header.length > SCHED_RPC_MAX_REQUEST) {
+            connection->closing = true;  // Not speaking the protocol
+            break;
+        }
+        if (connection->input_len - offset < header.length) break;
+        
+        rpc_handle_frame(c, &header, connection->input + offset + sizeof(header), header.length - sizeof(header));
+        offset += header.length;
+    }
+    memmove(connection->input, connection->input + offset, connection->input_len - offset);
+    connection->input_len -= offset;
+}
+
+void rpc_flush(RpcConnection* connection) {
+    size_t limit = connection->output_hold < connection->output_len ? connection->output_hold : connection->output_len;
+    while (connection->output_sent < limit) {
+        ssize_t n = send(connection->fd, connection->output + connection->output_sent,
+                         limit - connection->output_sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                // The peer is gone; nothing queued for it can be delivered
+                connection->closing = true;
+                connection->output_len = connection->output_sent = 0;
+            }
+            return;
+        }
+        connection->output_sent += (size_t)n;
+    }
+    if (connection->output_sent == connection->output_len) {
+        connection->output_len = 0;
+        connection->output_sent = 0;
+    }
+}
+
+void rpc_accept(int listen_fd) {
+    while (rpc_num_connections < MAX_RPC_CONNECTIONS) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) return;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        
+        RpcConnection* connection = &rpc_connections[rpc_num_connections++];
+        memset(connection, 0, sizeof(*connection));
+        connection->fd = fd;
+        connection->output_hold = SIZE_MAX;
+        connection->input = (unsigned char*)malloc(RPC_INPUT_BUFFER);
+    }
+}
+
+// Close connections that hit EOF or were marked closing, once their queued
+// writes have applied and every response has been sent, and renumber the
+// lane entries of the ones that move
+void rpc_close_finished() {
+    int remap[MAX_RPC_CONNECTIONS];
+    int kept = 0;
+    for (int c = 0; c < rpc_num_connections; c++) {
+        RpcConnection* connection = &rpc_connections[c];
+        if ((connection->closing || connection->eof) && connection->queued_writes == 0 &&
+            connection->output_sent == connection->output_len) {
+            close(rpc_connections[c].fd);
+            free(rpc_connections[c].input);
+            free(rpc_connections[c].output);
+            remap[c] = -1;
+        } else {
+            remap[c] = kept;
+            rpc_connections[kept++] = rpc_connections[c];
+        }
+    }
+    if (kept == rpc_num_connections) return;
+    rpc_num_connections = kept;
+    
+    for (int lane = 0; lane < RPC_LANES; lane++) {
+        RpcLane* queue = &rpc_lanes[lane];
+        for (int k = 0; k < queue->count; k++) {
+            RpcQueuedWrite* write = &queue->entries[(queue->head + k) % RPC_LANE_CAPACITY];
+            write->connection = remap[write->connection];
+        }
+    }
+}
+
+// Server-sent events: ./scheduler --serve [socket] --http [port]
+// GET /events keeps the response open and pushes one `delta` event per
+// catch-up, tagged with the schedule version as the SSE id. A client whose
+// last push has not drained yet is skipped. Once it drains it gets a
+// single delta from its last version, so slow clients coalesce instead of
+// queueing. Idle clients hold a socket and this struct, nothing else.
+#define MAX_SSE_CLIENTS 1024
+#define SSE_REQUEST_LIMIT 4096
+#define SSE_KEEPALIVE_MS 15000
+#define SSE_DELTA_CACHE 8
+
+typedef struct {
+    int fd;
+    char* request;                    // Until the request headers are complete
+    size_t request_len;
+    bool streaming;
+    unsigned long long sent_version;  // Last version pushed, 0 = nothing yet
+    char* output;                     // Freed whenever it drains
+    size_t output_len;
+    size_t output_sent;
+    double last_write_ms;
+    bool closing;
+} SseClient;
+
+// A growable text buffer for building responses
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} TextBuffer;
+
+SseClient sse_clients[MAX_SSE_CLIENTS];
+int sse_num_clients = 0;
+long long sse_events_sent = 0;
+long long sse_coalesced = 0;   // Versions folded into a later push
+
+// Delta events built this round, shared by every client at the same version
+typedef struct {
+    unsigned long long since;
+    TextBuffer text;
+} SseDeltaCache;
+
+SseDeltaCache sse_cache[SSE_DELTA_CACHE];
+int sse_cache_count = 0;
+unsigned long long sse_cache_version = 0;
+
+void text_reserve(TextBuffer* text, size_t extra) {
+    if (text->len + extra + 1 <= text->cap) return;
+    size_t cap = text->cap > 0 ? text->cap : 1024;
+    while (cap < text->len + extra + 1) cap *= 2;
+    text->data = (char*)realloc(text->data, cap);
+    text->cap = cap;
+}
+
+void text_append(TextBuffer* text, const char* data, size_t len) {
+    text_reserve(text, len);
+    memcpy(text->data + text->len, data, len);
+    text->len += len;
+    text->data[text->len] = '\0';
+}
+
+void text_printf(TextBuffer* text, const char* format, ...) {
+    // Measure into a stack byte rather than NULL, then write in place. A
+    // format error (negative length) appends nothing.
+    char probe[1];
+    va_list args;
+    va_start(args, format);
+    int needed = vsnprintf(probe, sizeof(probe), format, args);
+    va_end(args);
+    if (needed < 0) return;
+    
+    text_reserve(text, (size_t)needed);
+    va_start(args, format);
+    vsnprintf(text->data + text->len, (size_t)needed + 1, format, args);
+    va_end(args);
+    text->len += (size_t)needed;
+}
+
+void text_json_string(TextBuffer* text, const char* value) {
+    text_append(text, "\"", 1);
+    for (const unsigned char* p = (const unsigned char*)value; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') {
+            char escaped[2] = {'\\', (char)*p};
+            text_append(text, escaped, 2);
+        } else if (*p < 0x20) {
+            text_printf(text, "\\u%04x", *p);
+        } else {
+            text_append(text, (const char*)p, 1);
+        }
+    }
+    text_append(text, "\"", 1);
+}
+
+void sse_event_json(TextBuffer* text, const Event* event) {
+    text_printf(text, "{\"id\":%d,\"start\":%d,\"end\":%d,\"priority\":%d,\"color\":%d,\"track\":%d,\"room\":%d,\"scheduled\":%s,\"name\":",
+                event->id, event_start_minutes(event), event_end_minutes(event), event->priority,
+                event->color, event->track, event->room, event->scheduled ? "true" : "false");
+    text_json_string(text, event->name);
+    text_append(text, "}", 1);
+}
+
+// One SSE `delta` event taking a client from `since` to the snapshot.
+// A full resync (since 0, or older than the change log) sets "full".
+void sse_build_delta(TextBuffer* text, const ScheduleSnapshot* snapshot, unsigned long long since) {
+    static int ids[DELTA_LOG_CAPACITY];
+    static bool removed[DELTA_LOG_CAPACITY];
+    int changed = since > 0 ? schedule_changes_since(since, ids, removed) : -1;
+    bool full = changed < 0 || changed > MAX_EVENTS;
+    bool first = true;
+    
+    text_printf(text, "id: %llu\nevent: delta\ndata: {\"version\":%llu,\"full\":%s,\"events\":[",
+                snapshot->version, snapshot->version, full ? "true" : "false");
+    if (full) {
+        for (int i = 0; i < snapshot->num_events; i++) {
+            if (!first) text_append(text, ",", 1);
+            sse_event_json(text, &snapshot->events[i]);
+            first = false;
+        }
+    } else {
+        for (int k = 0; k < changed; k++) {
+            const Event* event = removed[k] ? NULL : snapshot_find_event(snapshot, ids[k]);
+            if (event == NULL) continue;
+            if (!first) text_append(text, ",", 1);
+            sse_event_json(text, event);
+            first = false;
+        }
+    }
+    text_append(text, "],\"removed\":[", 13);
+    first = true;
+    for (int k = 0; !full && k < changed; k++) {
+        if (!removed[k] && snapshot_find_event(snapshot, ids[k]) != NULL) continue;
+        text_printf(text, first ? "%d" : ",%d", ids[k]);
+        first = false;
+    }
+    text_append(text, "]}\n\n", 4);
+}
+
+const TextBuffer* sse_cached_delta(const ScheduleSnapshot* snapshot, unsigned long long since) {
+    if (sse_cache_version != snapshot->version) {
+        sse_cache_version = snapshot->version;
+        sse_cache_count = 0;
+    }
+    for (int k = 0; k < sse_cache_count; k++) {
+        if (sse_cache[k].since == since) return &sse_cache[k].text;
+    }
+    
+    SseDeltaCache* entry = &sse_cache[sse_cache_count < SSE_DELTA_CACHE ? sse_cache_count++ : SSE_DELTA_CACHE - 1];
+    entry->since = since;
+    entry->text.len = 0;
+    sse_build_delta(&entry->text, snapshot, since);
+    return &entry->text;
+}
+
+void sse_queue(SseClient* client, const char* data, size_t len) {
+    client->output = (char*)realloc(client->output, client->output_len + len);
+    memcpy(client->output + client->output_len, data, len);
+    client->output_len += len;
+}
+
+void sse_flush(SseClient* client) {
+    while (client->output_sent < client->output_len) {
+        ssize_t n = send(client->fd, client->output + client->output_sent,
+                         client->output_len - client->output_sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) client->closing = true;
+            return;
+        }
+        client->output_sent += (size_t)n;
+        client->last_write_ms = now_ms();
+    }
+    free(client->output);
+    client->output = NULL;
+    client->output_len = 0;
+    client->output_sent = 0;
+}
+
+// Parse the request once its headers are in: only GET /events is served
+void sse_handle_request(SseClient* client) {
+    static const char not_found[] =
+        "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    static const char stream_headers[] =
+        "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n"
+        "Connection: keep-alive\r\nAccess-Control-Allow-Origin: *\r\n\r\nretry: 2000\n\n";
+    
+    if (strncmp(client->request, "GET /events", 11) != 0 ||
+        (client->request[11] != ' ' && client->request[11] != '?')) {
+        sse_queue(client, not_found, sizeof(not_found) - 1);
+        sse_flush(client);
+        client->closing = true;
+        return;
+    }
+    
+    // A reconnecting EventSource resumes from its last id
+    const char* last_id = strstr(client->request, "\r\nLast-Event-ID:");
+    client->sent_version = last_id != NULL ? strtoull(last_id + 16, NULL, 10) : 0;
+    if (client->sent_version > snapshot_version) client->sent_version = 0;
+    
+    client->streaming = true;
+    free(client->request);
+    client->request = NULL;
+    sse_queue(client, stream_headers, sizeof(stream_headers) - 1);
+}
+
+void sse_read(SseClient* client) {
+    char discard[512];
+    for (;;) {
+        ssize_t n;
+        if (client->streaming) {
+            n = read(client->fd, discard, sizeof(discard));  // Nothing more is expected
+        } else {
+            if (client->request_len == SSE_REQUEST_LIMIT) {
+                client->closing = true;
+                return;
+            }
+            n = read(client->fd, client->request + client->request_len, SSE_REQUEST_LIMIT - client->request_len);
+        }
+        if (n <= 0) {
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) client->closing = true;
+            if (n == 0 || errno != EINTR) break;
+            continue;
+        }
+        if (!client->streaming) {
+            client->request_len += (size_t)n;
+            client->request[client->request_len] = '\0';
+            if (strstr(client->request, "\r\n\r\n") != NULL) sse_handle_request(client);
+        }
+    }
+}
+
+// Bring every drained client up to the published version, and keep idle
+// ones alive through proxies
+void sse_push_updates() {
+    const ScheduleSnapshot* snapshot = atomic_load(&published_snapshot);
+    double now = now_ms();
+    
+    for (int c = 0; c < sse_num_clients; c++) {
+        SseClient* client = &sse_clients[c];
+        if (!client->streaming || client->closing) continue;
+        if (client->output_len > 0) {
+            sse_flush(client);
+            if (client->output_len > 0) continue;  // Still slow: catch up later in one delta
+        }
+        
+        if (client->sent_version < snapshot->version) {
+            const TextBuffer* delta = sse_cached_delta(snapshot, client->sent_version);
+            if (client->sent_version > 0) sse_coalesced += (long long)(snapshot->version - client->sent_version - 1);
+            sse_queue(client, delta->data, delta->len);
+            client->sent_version = snapshot->version;
+            sse_events_sent++;
+        } else if (now - client->last_write_ms >= SSE_KEEPALIVE_MS) {
+            sse_queue(client, ": keepalive\n\n", 13);
+        } else {
+            continue;
+        }
+        sse_flush(client);
+    }
+}
+
+void sse_accept(int listen_fd) {
+    while (sse_num_clients < MAX_SSE_CLIENTS) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) return;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        
+        SseClient* client = &sse_clients[sse_num_clients++];
+        memset(client, 0, sizeof(*client));
+        client->fd = fd;
+        client->request = (char*)malloc(SSE_REQUEST_LIMIT + 1);
+        client->last_write_ms = now_ms();
+    }
+}
+
+void sse_close_finished() {
+    int kept = 0;
+    for (int c = 0; c < sse_num_clients; c++) {
+        if (sse_clients[c].closing) {
+            close(sse_clients[c].fd);
+            free(sse_clients[c].request);
+            free(sse_clients[c].output);
+        } else {
+            sse_clients[kept++] = sse_clients[c];
+        }
+    }
+    sse_num_clients = kept;
+}
+
+int sse_listen(int port) {
+    struct sockaddr_in address;
+    int one = 1;
+    
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons((uint16_t)port);
+    
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(fd, 512) < 0) {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+int run_rpc_server(int argc, char* argv[]) {
+    const char* path = SCHED_RPC_DEFAULT_PATH;
+    int http_port = 0;
+    static struct pollfd fds[MAX_RPC_CONNECTIONS + MAX_SSE_CLIENTS + 2];
+    struct sockaddr_un address;
+    
+    for (int a = 0; a < argc; a++) {
+        if (strcmp(argv[a], "--http") == 0) {
+            http_port = a + 1 < argc && atoi(argv[a + 1]) > 0 ? atoi(argv[++a]) : 8080;
+        } else {
+            path = argv[a];
+        }
+    }
+    
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        printf("Socket path too long: %s\n", path);
+        return 1;
+    }
+    strcpy(address.sun_path, path);
+    
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);
+    if (listen_fd < 0 || bind(listen_fd, (struct sockaddr*)&address, sizeof(address)) < 0 ||
+        listen(listen_fd, 128) < 0) {
+        printf("Could not listen on %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL) | O_NONBLOCK);
+    int http_fd = -1;
+    if (http_port > 0 && (http_fd = sse_listen(http_port)) < 0) {
+        printf("Could not listen on port %d: %s\n", http_port, strerror(errno));
+        close(listen_fd);
+        return 1;
+    }
+    signal(SIGINT, rpc_handle_signal);
+    signal(SIGTERM, rpc_handle_signal);
+    signal(SIGPIPE, SIG_IGN);
+    
+    verbose_output = false;
+    dynamic_reschedule();  // Publish version 1 so DELTA and FREE_SLOTS have a base
+    printf("Serving scheduler RPC on %s (Ctrl+C to stop)\n", path);
+    if (http_fd >= 0) printf("Streaming schedule changes at http://127.0.0.1:%d/events\n", http_port);
+    fflush(stdout);
+    
+    while (!rpc_stop) {
+        // Layout: RPC listener, RPC connections, HTTP listener, SSE clients
+        int polled = rpc_num_connections;
+        int sse_polled = sse_num_clients;
+        int sse_base = polled + 2;
+        fds[0].fd = listen_fd;
+        fds[0].events = rpc_num_connections < MAX_RPC_CONNECTIONS ? POLLIN : 0;
+        for (int c = 0; c < polled; c++) {
+            RpcConnection* connection = &rpc_connections[c];
+            bool reading = !connection->closing && !connection->eof;
+            fds[c + 1].fd = connection->fd;
+            fds[c + 1].events = (connection->output_len > connection->output_sent ? POLLOUT : 0) |
+                                (reading && connection->output_len < RPC_OUTPUT_HIGH_WATER ? POLLIN : 0);
+        }
+        fds[polled + 1].fd = http_fd;
+        fds[polled + 1].events = sse_num_clients < MAX_SSE_CLIENTS ? POLLIN : 0;
+        for (int c = 0; c < sse_polled; c++) {
+            fds[sse_base + c].fd = sse_clients[c].fd;
+            fds[sse_base + c].events = POLLIN | (sse_clients[c].output_len > 0 ? POLLOUT : 0);
+        }
+        
+        bool queued = rpc_lanes[RPC_LANE_INTERACTIVE].count + rpc_lanes[RPC_LANE_BULK].count > 0;
+        int timeout = queued ? 0 : clock_poll_timeout();
+        if (!queued && sse_polled > 0 && (timeout < 0 || timeout > SSE_KEEPALIVE_MS)) timeout = SSE_KEEPALIVE_MS;
+        if (poll(fds, (nfds_t)(sse_base + sse_polled), timeout) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        double round_start = now_ms();
+        
+        for (int c = 0; c < polled; c++) {
+            RpcConnection* connection = &rpc_connections[c];
+            if (!connection->closing && !connection->eof && (fds[c + 1].revents & (POLLIN | POLLHUP | POLLERR))) {
+                rpc_read(connection);
+            }
+        }
+        if (fds[0].revents & POLLIN) rpc_accept(listen_fd);
+        for (int c = 0; c < sse_polled; c++) {
+            if (fds[sse_base + c].revents & (POLLIN | POLLHUP | POLLERR)) sse_read(&sse_clients[c]);
+        }
+        if (http_fd >= 0 && (fds[polled + 1].revents & POLLIN)) sse_accept(http_fd);
+        
+        for (int c = 0; c < rpc_num_connections; c++) {
+            if (!rpc_connections[c].closing) rpc_process_input(c);
+        }
+        rpc_drain_lanes();
+        rpc_commit();
+        clock_tick();
+        rpc_update_holds();
+        for (int c = 0; c < rpc_num_connections; c++) {
+            rpc_flush(&rpc_connections[c]);
+        }
+        rpc_close_finished();
+        sse_push_updates();
+        sse_close_finished();
+        rpc_round_ms += (now_ms() - round_start - rpc_round_ms) / 8.0;
+    }
+    
+    // Finish the admitted writes so every queued response is answered
+    while (rpc_lanes[RPC_LANE_INTERACTIVE].count + rpc_lanes[RPC_LANE_BULK].count > 0) {
+        rpc_drain_lanes();
+    }
+    rpc_commit();
+    rpc_update_holds();
+    for (int c = 0; c < rpc_num_connections; c++) {
+        rpc_flush(&rpc_connections[c]);
+        rpc_connections[c].closing = true;
+        rpc_connections[c].output_len = rpc_connections[c].output_sent = 0;   // Unsent output is dropped on exit
+    }
+    rpc_close_finished();
+    for (int c = 0; c < sse_num_clients; c++) {
+        sse_clients[c].closing = true;
+    }
+    sse_close_finished();
+    close(listen_fd);
+    if (http_fd >= 0) close(http_fd);
+    unlink(path);
+    printf("\nServed %lld requests in %lld commits, final schedule version %llu\n",
+           rpc_requests, rpc_commits, snapshot_version);
+    printf("Writes admitted: %lld interactive, %lld bulk; refused as overloaded: %lld interactive, %lld bulk\n",
+           rpc_lanes[RPC_LANE_INTERACTIVE].admitted, rpc_lanes[RPC_LANE_BULK].admitted,
+           rpc_lanes[RPC_LANE_INTERACTIVE].refused, rpc_lanes[RPC_LANE_BULK].refused);
+    if (http_fd >= 0) {
+        printf("Pushed %lld SSE events, %lld versions coalesced for slow clients\n",
+               sse_events_sent, sse_coalesced);
+    }
+    return 0;
+}
+
+// Example shared-memory reader: ./scheduler --shm-read [name] [watch seconds]
+// Prints the published schedule. With a watch time it keeps polling the
+// version word and re-reads on every change, then reports read costs.
+int run_shm_reader(int argc, char* argv[]) {
+    const char* name = argc > 0 ? argv[0] : SCHED_SHM_DEFAULT_NAME;
+    double watch_seconds = argc > 1 ? atof(argv[1]) : 0;
+    static SchedEventRecord records[SCHED_SHM_CAPACITY];
+    
+    const SchedShmRegion* region = sched_shm_open(name);
+    if (region == NULL) {
+        printf("No schedule published at %s (start ./scheduler --shm %s)\n", name, name);
+        return 1;
+    }
+    
+    uint64_t seen_version = 0;
+    long long reads = 0, retries = 0;
+    double read_ms = 0, deadline = now_ms() + watch_seconds * 1000.0;
+    do {
+        uint64_t version = atomic_load_explicit((_Atomic uint64_t*)&region->version, memory_order_acquire);
+        if (version == seen_version && reads > 0) {
+            usleep(1000);
+            continue;
+        }
+        
+        uint32_t sequence, count;
+        const SchedShmBuffer* buffer;
+        double start = now_ms();
+        for (;;) {
+            buffer = sched_shm_read_begin(region, &sequence);
+            count = buffer->count;
+            if (count > SCHED_SHM_CAPACITY) count = SCHED_SHM_CAPACITY;
+            seen_version = buffer->version;
+            memcpy(records, buffer->events, count * sizeof(SchedEventRecord));
+            if (sched_shm_read_valid(buffer, sequence)) break;
+            retries++;
+        }
+        read_ms += now_ms() - start;
+        reads++;
+        
+        if (reads == 1) {
+            printf("\n=== SHARED SCHEDULE %s (version %llu, %u events) ===\n",
+                   name, (unsigned long long)seen_version, count);
+            for (uint32_t k = 0; k < count; k++) {
+                const SchedEventRecord* record = &records[k];
+                printf("ID %4d  %02d:%02d-%02d:%02d  P%d  color %2d  %-9s %s\n", record->event_id,
+                       record->start_minute / 60, record->start_minute % 60,
+                       record->end_minute / 60, record->end_minute % 60, record->priority, record->color,
+                       record->scheduled ? "scheduled" : "pending", record->name);
+            }
+        }
+    } while (now_ms() < deadline);
+    
+    if (watch_seconds > 0) {
+        printf("\nRead %lld versions (last %llu), %lld torn reads retried, %.1f us per full read\n",
+               reads, (unsigned long long)seen_version, retries, reads > 0 ? read_ms * 1000.0 / reads : 0.0);
+    }
+    sched_shm_close(region);
+    return 0;
+}
+
+void print_graph() {
+    ensure_conflict_graph(NULL);
+    printf("\n=== CONFLICT GRAPH ===\n");
+    for (int i = 0; i < num_events; i++) {
+        printf("Event %d (%s, degree=%d): ", events[i].id, events[i].name, events[i].degree);
+        AdjListNode* current = conflict_graph.adjacency_list[i];
+        while (current != NULL) {
+            printf("%d ", events[current->event_index].id);
+            current = current->next;
+        }
+        printf("\n");
+    }
+    printf("====================\n\n");
+}
+
+void print_schedule() {
+    printf("\n=== CURRENT SCHEDULE ===\n");
+    printf("%-4s %-20s %-12s %-8s %-8s %-10s\n", 
+           "ID", "Event Name", "Time", "Duration", "Priority", "Status");
+    printf("------------------------------------------------------------\n");
+    
+    for (int i = 0; i < num_events; i++) {
+        printf("%-4d %-20s %02d:%02d-%02d:%02d %-8d %-8d %-10s\n",
+               events[i].id,
+               events[i].name,
+               events[i].time.start_hour, events[i].time.start_minute,
+               events[i].time.end_hour, events[i].time.end_minute,
+               events[i].duration_minutes,
+               events[i].priority,
+               events[i].scheduled ? "Scheduled" : "Unscheduled");
+    }
+    printf("========================================\n\n");
+}
+
+void print_events() {
+    printf("\n=== ALL EVENTS ===\n");
+    for (int i = 0; i < num_events; i++) {
+        printf("ID: %d, Name: %s, Time: %02d:%02d-%02d:%02d, Duration: %d min, Priority: %d",
+               events[i].id, events[i].name,
+               events[i].time.start_hour, events[i].time.start_minute,
+               events[i].time.end_hour, events[i].time.end_minute,
+               events[i].duration_minutes, events[i].priority);
+        if (events[i].track >= 0) printf(", Track: %d", events[i].track);
+        printf("\n");
+    }
+    printf("==================\n\n");
+}
+
+// Synthetic workload description for the benchmark suite
+typedef struct {
+    const char* name;
+    int window_start;   // Earliest start, minutes from midnight
+    int window_end;     // Latest end, minutes from midnight
+    int min_duration;
+    int max_duration;
+} Workload;
+
+Workload bench_workloads[] = {
+    {"sparse", 0, 24 * 60, 15, 60},
+    {"office", 8 * 60, 18 * 60, 30, 120},
+    {"dense", 9 * 60, 13 * 60, 60, 240},
+};
+#define NUM_BENCH_WORKLOADS ((int)(sizeof(bench_workloads) / sizeof(bench_workloads[0])))
+
+// xorshift64* so a seed always reproduces the same workload
+unsigned int bench_random(unsigned long long* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return (unsigned int)((*state * 2685821657736338717ULL) >> 32);
+}
+
+// Replace all events with n generated ones. Leaves a batch open so the
+// caller decides which phase to run and time.
+void load_workload(const Workload* workload, int n, unsigned long long seed) {
+    unsigned long long state = seed * 2654435761ULL + 1;
+    char name[50];
+    
+    clear_all_events();
+    begin_batch();
+    for (int i = 0; i < n; i++) {
+        int duration = workload->min_duration +
+                       (int)(bench_random(&state) % (unsigned int)(workload->max_duration - workload->min_duration + 1));
+        int span = workload->window_end - workload->window_start - duration;
+        int start = workload->window_start + (span > 0 ? (int)(bench_random(&state) % (unsigned int)span) : 0);
+        int priority = 1 + (int)(bench_random(&state) % 5);
+        
+        snprintf(name, sizeof(name), "%s-%d", workload->name, i + 1);
+        add_event(name, start / 60, start % 60, duration, priority);
+    }
+}
+
+// Compare the scheduling strategies on identical workloads:
+//   ./scheduler --bench [events] [seed] [rooms]
+int run_benchmarks(int argc, char* argv[]) {
+    int n = argc > 0 ? atoi(argv[0]) : 1000;
+    unsigned long long seed = argc > 1 ? strtoull(argv[1], NULL, 10) : 42;
+    int k = argc > 2 ? atoi(argv[2]) : 4;
+    const int repetitions = 5;
+    SchedulingStrategy strategies[] = {
+        STRATEGY_PRIORITY_GREEDY, STRATEGY_EARLIEST_FINISH, STRATEGY_EARLIEST_FINISH_K
+    };
+    
+    if (n < 1 || n > MAX_EVENTS) n = MAX_EVENTS;
+    verbose_output = false;
+    eft_room_count = k;
+    
+    printf("=== SCHEDULING STRATEGY BENCHMARK (n=%d, seed=%llu, k=%d) ===\n", n, seed, k);
+    printf("%-8s %-26s %10s %10s %13s\n", "Workload", "Strategy", "Best(ms)", "Scheduled", "Priority sum");
+    printf("------------------------------------------------------------------------\n");
+    
+    for (int w = 0; w < NUM_BENCH_WORKLOADS; w++) {
+        for (int s = 0; s < 3; s++) {
+            double best = -1;
+            int scheduled = 0, priority_sum = 0;
+            
+            for (int rep = 0; rep < repetitions; rep++) {
+                load_workload(&bench_workloads[w], n, seed);
+                double start = now_ms();
+                run_scheduling_strategy(strategies[s], NULL);
+                double elapsed = now_ms() - start;
+                if (best < 0 || elapsed < best) best = elapsed;
+            }
+            
+            for (int i = 0; i < num_events; i++) {
+                if (events[i].scheduled) {
+                    scheduled++;
+                    priority_sum += events[i].priority;
+                }
+            }
+            printf("%-8s %-26s %10.3f %10d %13d\n", bench_workloads[w].name,
+                   strategy_name(strategies[s]), best, scheduled, priority_sum);
+        }
+    }
+    printf("========================================================================\n");
+    
+    clear_all_events();
+    return 0;
+}
+
+// Least-squares fit of t = a * work + b * edges through the origin, weighted
+// by 1/t² so small and large workloads count equally (relative error)
+typedef struct {
+    double sww, swe, see, stw, ste;
+} CostFit;
+
+void cost_fit_add(CostFit* fit, double work, double edges, double elapsed_us) {
+    if (elapsed_us <= 0) return;
+    double weight = 1.0 / (elapsed_us * elapsed_us);
+    fit->sww += weight * work * work;
+    fit->swe += weight * work * edges;
+    fit->see += weight * edges * edges;
+    fit->stw += weight * elapsed_us * work;
+    fit->ste += weight * elapsed_us * edges;
+}
+
+// Solve the 2x2 normal equations; negative terms are clamped by refitting
+// the remaining one alone so the model never predicts negative cost
+void cost_fit_solve(const CostFit* fit, double* work_coefficient, double* edge_coefficient) {
+    double det = fit->sww * fit->see - fit->swe * fit->swe;
+    double a = det != 0 ? (fit->stw * fit->see - fit->ste * fit->swe) / det : 0;
+    double b = det != 0 ? (fit->ste * fit->sww - fit->stw * fit->swe) / det : -1;
+    
+    if (a < 0 || b < 0) {
+        if (a < 0 && det != 0) {
+            a = 0;
+            b = fit->see > 0 ? fit->ste / fit->see : 0;
+        } else {
+            b = 0;
+            a = fit->sww > 0 ? fit->stw / fit->sww : 0;
+        }
+    }
+    *work_coefficient = a;
+    *edge_coefficient = b;
+}
+
+bool load_cost_model(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) return false;
+    
+    char name[64];
+    double value;
+    while (fscanf(file, "%63s %lf", name, &value) == 2) {
+        if (strcmp(name, "naive_build") == 0) cost_model.naive_build = value;
+        else if (strcmp(name, "naive_build_edge") == 0) cost_model.naive_build_edge = value;
+        else if (strcmp(name, "sweep_build") == 0) cost_model.sweep_build = value;
+        else if (strcmp(name, "sweep_build_edge") == 0) cost_model.sweep_build_edge = value;
+        else if (strcmp(name, "welsh_powell") == 0) cost_model.welsh_powell = value;
+        else if (strcmp(name, "welsh_powell_edge") == 0) cost_model.welsh_powell_edge = value;
+        else if (strcmp(name, "interval_partition") == 0) cost_model.interval_partition = value;
+        else if (strcmp(name, "dsatur") == 0) cost_model.dsatur = value;
+        else if (strcmp(name, "dsatur_edge") == 0) cost_model.dsatur_edge = value;
+    }
+    fclose(file);
+    return true;
+}
+
+bool save_cost_model(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) return false;
+    
+    fprintf(file, "naive_build %.6g\n", cost_model.naive_build);
+    fprintf(file, "naive_build_edge %.6g\n", cost_model.naive_build_edge);
+    fprintf(file, "sweep_build %.6g\n", cost_model.sweep_build);
+    fprintf(file, "sweep_build_edge %.6g\n", cost_model.sweep_build_edge);
+    fprintf(file, "welsh_powell %.6g\n", cost_model.welsh_powell);
+    fprintf(file, "welsh_powell_edge %.6g\n", cost_model.welsh_powell_edge);
+    fprintf(file, "interval_partition %.6g\n", cost_model.interval_partition);
+    fprintf(file, "dsatur %.6g\n", cost_model.dsatur);
+    fprintf(file, "dsatur_edge %.6g\n", cost_model.dsatur_edge);
+    fclose(file);
+    return true;
+}
+
+// Time every graph algorithm on the benchmark workloads at several sizes and
+// fit the cost model coefficients:
+//   ./scheduler --calibrate [output file] [seed]
+int run_calibration(int argc, char* argv[]) {
+    const char* path = argc > 0 ? argv[0] : "cost_model.txt";
+    unsigned long long seed = argc > 1 ? strtoull(argv[1], NULL, 10) : 42;
+    int sizes[] = {125, 250, 500, 1000, 2000};
+    const int repetitions = 3;
+    CostFit naive = {0}, sweep = {0}, wp = {0}, ip = {0}, ds = {0};
+    
+    verbose_output = false;
+    task_threads = 1;  // The model predicts single-threaded cost
+    printf("=== COST MODEL CALIBRATION (seed=%llu) ===\n", seed);
+    printf("%-8s %6s %8s %9s %9s %9s %9s %9s\n", "Workload", "n", "Edges",
+           "Naive", "Sweep", "W-Powell", "Interval", "DSatur");
+    printf("(best of %d runs, microseconds)\n", repetitions);
+    
+    for (int w = 0; w < NUM_BENCH_WORKLOADS; w++) {
+        for (int z = 0; z < (int)(sizeof(sizes) / sizeof(sizes[0])); z++) {
+            double best[5] = {-1, -1, -1, -1, -1};
+            
+            load_workload(&bench_workloads[w], sizes[z], seed);
+            compute_schedule_stats(&schedule_stats);
+            
+            for (int rep = 0; rep < repetitions; rep++) {
+                double t[5];
+                double start = now_ms();
+                build_conflict_graph_naive(NULL);
+                t[0] = now_ms() - start;
+                
+                start = now_ms();
+                build_conflict_graph_sweep(NULL);
+                t[1] = now_ms() - start;
+                
+                start = now_ms();
+                welsh_powell_coloring(NULL);
+                t[2] = now_ms() - start;
+                
+                start = now_ms();
+                interval_partition_coloring(NULL);
+                t[3] = now_ms() - start;
+                
+                start = now_ms();
+                dsatur_coloring(NULL);
+                t[4] = now_ms() - start;
+                
+                for (int a = 0; a < 5; a++) {
+                    if (best[a] < 0 || t[a] < best[a]) best[a] = t[a];
+                }
+            }
+            
+            double n = sizes[z];
+            double e = (double)schedule_stats.num_edges;
+            cost_fit_add(&naive, n * n / 2, e, best[0] * 1000);
+            cost_fit_add(&sweep, n_log_n(sizes[z]), e, best[1] * 1000);
+            cost_fit_add(&wp, n_log_n(sizes[z]), e, best[2] * 1000);
+            cost_fit_add(&ip, n_log_n(sizes[z]), 0, best[3] * 1000);
+            cost_fit_add(&ds, n * schedule_stats.largest_component, e, best[4] * 1000);
+            
+            printf("%-8s %6d %8lld %9.1f %9.1f %9.1f %9.1f %9.1f\n", bench_workloads[w].name,
+                   sizes[z], schedule_stats.num_edges, best[0] * 1000, best[1] * 1000,
+                   best[2] * 1000, best[3] * 1000, best[4] * 1000);
+        }
+    }
+    
+    double unused;
+    cost_fit_solve(&naive, &cost_model.naive_build, &cost_model.naive_build_edge);
+    cost_fit_solve(&sweep, &cost_model.sweep_build, &cost_model.sweep_build_edge);
+    cost_fit_solve(&wp, &cost_model.welsh_powell, &cost_model.welsh_powell_edge);
+    cost_fit_solve(&ip, &cost_model.interval_partition, &unused);
+    cost_fit_solve(&ds, &cost_model.dsatur, &cost_model.dsatur_edge);
+    
+    printf("\nFitted coefficients (us per unit of work, us per edge):\n");
+    printf("  naive build         %.6g  %.6g\n", cost_model.naive_build, cost_model.naive_build_edge);
+    printf("  sweep build         %.6g  %.6g\n", cost_model.sweep_build, cost_model.sweep_build_edge);
+    printf("  Welsh-Powell        %.6g  %.6g\n", cost_model.welsh_powell, cost_model.welsh_powell_edge);
+    printf("  interval partition  %.6g\n", cost_model.interval_partition);
+    printf("  DSatur              %.6g  %.6g\n", cost_model.dsatur, cost_model.dsatur_edge);
+    
+    if (save_cost_model(path)) {
+        printf("Saved cost model to %s\n", path);
+    } else {
+        printf("Could not write cost model to %s\n", path);
+    }
+    
+    clear_all_events();
+    return 0;
+}
+
+void print_algorithm_selection() {
+    compute_schedule_stats(&schedule_stats);
+    
+    printf("\n=== ALGORITHM SELECTION ===\n");
+    printf("Events: %d, conflicts: %lld, average overlap: %.2f\n", schedule_stats.num_events,
+           schedule_stats.num_edges, schedule_stats.average_overlap);
+    printf("Largest component: %d, max simultaneous events: %d\n",
+           schedule_stats.largest_component, schedule_stats.max_overlap);
+    printf("Graph build: %-14s (naive %.1f us, sweep %.1f us) forced: %s\n",
+           graph_build_name(choose_graph_build(&schedule_stats)),
+           estimate_build_cost(GRAPH_BUILD_NAIVE, &schedule_stats),
+           estimate_build_cost(GRAPH_BUILD_SWEEP, &schedule_stats),
+           graph_build_name(forced_graph_build));
+    printf("Coloring:    %-14s (W-Powell %.1f us, interval %.1f us, DSatur %.1f us) forced: %s\n",
+           coloring_name(choose_coloring(&schedule_stats)),
+           estimate_coloring_cost(COLORING_WELSH_POWELL, &schedule_stats),
+           estimate_coloring_cost(COLORING_INTERVAL_PARTITION, &schedule_stats),
+           estimate_coloring_cost(COLORING_DSATUR, &schedule_stats),
+           coloring_name(forced_coloring));
+    printf("Graph mode:  %-14s (%lld edits, %lld uses) forced: %s\n",
+           graph_mode_name(choose_graph_mode()), graph_edits, graph_uses,
+           graph_mode_name(forced_graph_mode));
+    printf("===========================\n\n");
+}
+
+// Pin an algorithm for testing; 0 returns a phase to automatic selection
+void force_algorithms() {
+    int build, coloring, mode;
+    
+    print_algorithm_selection();
+    printf("Graph build (0=auto 1=naive 2=sweep): ");
+    scanf("%d", &build);
+    printf("Coloring (0=auto 1=Welsh-Powell 2=interval partitioning 3=DSatur): ");
+    scanf("%d", &coloring);
+    printf("Graph mode (0=auto 1=eager 2=lazy): ");
+    scanf("%d", &mode);
+    
+    if (build >= GRAPH_BUILD_AUTO && build <= GRAPH_BUILD_SWEEP) forced_graph_build = (GraphBuildAlgorithm)build;
+    if (coloring >= COLORING_AUTO && coloring <= COLORING_DSATUR) forced_coloring = (ColoringAlgorithm)coloring;
+    if (mode >= GRAPH_MODE_AUTO && mode <= GRAPH_MODE_LAZY) forced_graph_mode = (GraphMode)mode;
+    
+    print_algorithm_selection();
+}
+
+// Serial vs parallel placement of a large backlog on identical workloads:
+//   ./scheduler --bench-placement [events] [seed]
+// The checksum must match across thread counts (deterministic per seed).
+int run_placement_benchmark(int argc, char* argv[]) {
+    int n = argc > 0 ? atoi(argv[0]) : MAX_EVENTS;
+    unsigned long long seed = argc > 1 ? strtoull(argv[1], NULL, 10) : 1;
+    int thread_counts[] = {1, 2, 4, 8, 16};
     
-    new_event.color = -1;
-    new_event.scheduled = false;
-    new_event.priority = priority;
-    new_event.degree = 0;
+    if (n < 1 || n > MAX_EVENTS) n = MAX_EVENTS;
+    verbose_output = false;
+    placement_seed = seed;
     
-    events[num_events] = new_event;
+    printf("=== PLACEMENT BENCHMARK (n=%d, seed=%llu, %d CPUs) ===\n", n, seed,
+           (int)sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%-22s %10s %8s %20s\n", "Mode", "Time(ms)", "Placed", "Checksum");
+    printf("------------------------------------------------------------\n");
     
-    // Add to hash table for O(1) lookup
-    hash_insert(new_event.id, num_events);
+    for (int mode = -1; mode < (int)(sizeof(thread_counts) / sizeof(thread_counts[0])); mode++) {
+        load_workload(&bench_workloads[1], n, 42);
+        run_scheduling_strategy(STRATEGY_PRIORITY_GREEDY, NULL);
+        int before = 0;
+        for (int i = 0; i < num_events; i++) {
+            if (events[i].scheduled) before++;
+        }
+        
+        double start = now_ms();
+        if (mode == -1) {
+            place_unscheduled_serial(NULL);
+        } else {
+            place_unscheduled_parallel(NULL, thread_counts[mode]);
+        }
+        double elapsed = now_ms() - start;
+        
+        int placed = -before;
+        unsigned long long checksum = 0;
+        for (int i = 0; i < num_events; i++) {
+            if (events[i].scheduled) {
+                placed++;
+                checksum = checksum * 31 + (unsigned long long)events[i].id * 1440 + event_start_minutes(&events[i]);
+            }
+        }
+        
+        char label[32];
+        if (mode == -1) {
+            snprintf(label, sizeof(label), "serial");
+        } else {
+            snprintf(label, sizeof(label), "parallel %d thread%s", thread_counts[mode],
+                     thread_counts[mode] == 1 ? "" : "s");
+        }
+        printf("%-22s %10.3f %8d %20llu\n", label, elapsed, placed, checksum);
+    }
+    printf("============================================================\n");
     
-    num_events++;
+    clear_all_events();
+    return 0;
+}
+
+// Graph phases on the task runtime:
+//   ./scheduler --bench-tasks [events] [seed]
+// Events fall into 46 half-hour clusters whose sizes shrink like 1/c, so the
+// components are very uneven. The checksum must match across thread counts.
+void load_clustered_workload(int n, unsigned long long seed) {
+    const int clusters = 46;
+    unsigned long long state = seed * 2654435761ULL + 1;
+    double weight_sum = 0;
+    char name[50];
     
-    printf("Event '%s' added successfully with ID: %d\n", name, new_event.id);
+    for (int c = 0; c < clusters; c++) weight_sum += 1.0 / (c + 1);
     
-    // Rebuild and reschedule
-    build_conflict_graph();
+    clear_all_events();
+    begin_batch();
+    for (int c = 0, made = 0; c < clusters && made < n; c++) {
+        int size = c == clusters - 1 ? n - made : (int)(n / weight_sum / (c + 1));
+        for (int i = 0; i < size && made < n; i++, made++) {
+            // 25-minute window per cluster keeps a 5-minute gap between them
+            int duration = 5 + (int)(bench_random(&state) % 16);
+            int start = 30 + c * 30 + (int)(bench_random(&state) % (unsigned int)(26 - duration));
+            snprintf(name, sizeof(name), "cluster%d-%d", c, i + 1);
+            add_event(name, start / 60, start % 60, duration, 1 + (int)(bench_random(&state) % 5));
+        }
+    }
+}
+
+int run_task_benchmark(int argc, char* argv[]) {
+    int n = argc > 0 ? atoi(argv[0]) : MAX_EVENTS;
+    unsigned long long seed = argc > 1 ? strtoull(argv[1], NULL, 10) : 1;
+    int thread_counts[] = {1, 2, 4, 8, 16};
+    
+    if (n < 1 || n > MAX_EVENTS) n = MAX_EVENTS;
+    verbose_output = false;
+    load_clustered_workload(n, seed);
+    build_component_layout(&component_layout);
+    
+    printf("=== TASK RUNTIME BENCHMARK (n=%d, %d components, %d CPUs) ===\n", num_events,
+           component_layout.num_components, (int)sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%-8s %12s %12s %12s %10s %20s\n", "Threads", "Build(ms)", "Interval(ms)", "DSatur(ms)",
+           "Edges", "Checksum");
+    printf("------------------------------------------------------------------------------\n");
+    
+    for (int t = 0; t < (int)(sizeof(thread_counts) / sizeof(thread_counts[0])); t++) {
+        task_threads = thread_counts[t];
+        
+        double start = now_ms();
+        build_conflict_graph_sweep(NULL);
+        double build_ms = now_ms() - start;
+        
+        long long edges = 0;
+        for (int i = 0; i < num_events; i++) edges += events[i].degree;
+        
+        start = now_ms();
+        interval_partition_coloring(NULL);
+        double interval_ms = now_ms() - start;
+        unsigned long long checksum = 0;
+        for (int i = 0; i < num_events; i++) checksum = checksum * 31 + (unsigned long long)(events[i].color + 1);
+        
+        start = now_ms();
+        dsatur_coloring(NULL);
+        double dsatur_ms = now_ms() - start;
+        for (int i = 0; i < num_events; i++) checksum = checksum * 31 + (unsigned long long)(events[i].color + 1);
+        
+        printf("%-8d %12.3f %12.3f %12.3f %10lld %20llu\n", thread_counts[t], build_ms, interval_ms,
+               dsatur_ms, edges / 2, checksum);
+    }
+    printf("==============================================================================\n");
+    
+    task_threads = 0;
+    clear_all_events();
+    return 0;
+}
+
+// Reader scaling under a continuous writer:
+//   ./scheduler --bench-snapshot [seconds per step] [max readers]
+// Readers do id lookups and free-slot queries on published snapshots while
+// the writer keeps adding and removing events with full reschedules.
+typedef struct {
+    atomic_bool* stop;
+    unsigned long long seed;
+    long long reads;
+    long long misses;
+} SnapshotReaderJob;
+
+void* snapshot_reader_main(void* arg) {
+    SnapshotReaderJob* job = (SnapshotReaderJob*)arg;
+    unsigned long long state = job->seed;
+    int starts[MAX_TIME_SLOTS];
+    
+    while (!atomic_load(&job->stop[0])) {
+        const ScheduleSnapshot* snapshot = snapshot_acquire();
+        if (snapshot == NULL) {
+            snapshot_release();
+            continue;
+        }
+        int max_id = snapshot->num_events > 0 ? snapshot->events[snapshot->by_id[snapshot->num_events - 1]].id : 1;
+        
+        if (snapshot_find_event(snapshot, 1 + (int)(bench_random(&state) % (unsigned int)max_id)) == NULL) {
+            job->misses++;
+        }
+        snapshot_find_free_slots(snapshot, 30 + 30 * (int)(bench_random(&state) % 4), starts, MAX_TIME_SLOTS);
+        snapshot_release();
+        job->reads++;
+    }
+    snapshot_unregister_reader();
+    return NULL;
+}
+
+int run_snapshot_benchmark(int argc, char* argv[]) {
+    double seconds = argc > 0 ? atof(argv[0]) : 1.0;
+    int max_readers = argc > 1 ? atoi(argv[1]) : 8;
+    pthread_t threads[MAX_SNAPSHOT_READERS];
+    SnapshotReaderJob jobs[MAX_SNAPSHOT_READERS];
+    atomic_bool stop;
+    
+    if (max_readers < 1) max_readers = 1;
+    if (max_readers > MAX_SNAPSHOT_READERS) max_readers = MAX_SNAPSHOT_READERS;
+    verbose_output = false;
+    reschedule_budget_ms = 0;
+    
+    load_workload(&bench_workloads[1], 500, 42);
+    end_batch();
+    
+    printf("=== SNAPSHOT READ SCALING (%.1fs per step, %d CPUs) ===\n", seconds,
+           (int)sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%-8s %14s %14s %10s %10s\n", "Readers", "Reads/s", "Reads/s/thread", "Writes", "Version");
+    printf("------------------------------------------------------------\n");
+    
+    for (int readers = 1; readers <= max_readers; readers *= 2) {
+        unsigned long long state = 7;
+        int writes = 0;
+        atomic_store(&stop, false);
+        
+        for (int r = 0; r < readers; r++) {
+            jobs[r].stop = &stop;
+            jobs[r].seed = 1000003ULL * (unsigned long long)(r + 1);
+            jobs[r].reads = 0;
+            jobs[r].misses = 0;
+            pthread_create(&threads[r], NULL, snapshot_reader_main, &jobs[r]);
+        }
+        
+        // The writer never waits for readers: alternate adds and removes
+        double start = now_ms();
+        while (now_ms() - start < seconds * 1000) {
+            if (writes % 2 == 0) {
+                int minute = (int)(bench_random(&state) % (23 * 60));
+                add_event("writer", minute / 60, minute % 60, 30 + (int)(bench_random(&state) % 90), 3);
+            } else {
+                remove_event(next_event_id - 1);
+            }
+            writes++;
+        }
+        atomic_store(&stop, true);
+        
+        long long total = 0;
+        for (int r = 0; r < readers; r++) {
+            pthread_join(threads[r], NULL);
+            total += jobs[r].reads;
+        }
+        double elapsed = (now_ms() - start) / 1000.0;
+        printf("%-8d %14.0f %14.0f %10d %10llu\n", readers, total / elapsed, total / elapsed / readers,
+               writes, snapshot_version);
+    }
+    printf("============================================================\n");
+    
+    clear_all_events();
+    return 0;
+}
+
+// Write throughput under contention, pipeline vs a global lock:
+//   ./scheduler --bench-pipeline [producers] [edits per producer] [batch window us]
+// The last mode submits UI-style bursts (add, two requirement edits,
+// remove) without waiting in between, which the pipeline coalesces.
+typedef enum {
+    PRODUCER_MUTEX,
+    PRODUCER_PIPELINE,
+    PRODUCER_BURSTS
+} ProducerMode;
+
+typedef struct {
+    int producer;
+    int edits;
+    ProducerMode mode;
+} PipelineProducerJob;
+
+pthread_mutex_t bench_engine_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void* pipeline_producer_main(void* arg) {
+    PipelineProducerJob* job = (PipelineProducerJob*)arg;
+    unsigned long long state = 99991ULL * (unsigned long long)(job->producer + 1);
+    
+    for (int e = 0; e < job->edits; e++) {
+        int minute = (int)(bench_random(&state) % (23 * 60));
+        int duration = 30 + (int)(bench_random(&state) % 90);
+        
+        if (job->mode == PRODUCER_BURSTS) {
+            MutationRequest* add = submit_add_event("client", minute / 60, minute % 60, duration, 3);
+            int id = add->event_id;
+            MutationRequest* first = submit_set_requirements(id, 10, FEATURE_PROJECTOR);
+            MutationRequest* second = submit_set_requirements(id, 12, FEATURE_PROJECTOR);
+            MutationRequest* remove = submit_remove_event(id);
+            mutation_wait(add, NULL);
+            mutation_wait(first, NULL);
+            mutation_wait(second, NULL);
+            mutation_wait(remove, NULL);
+        } else if (job->mode == PRODUCER_PIPELINE) {
+            int id = mutation_wait(submit_add_event("client", minute / 60, minute % 60, duration, 3), NULL);
+            mutation_wait(submit_remove_event(id), NULL);
+        } else {
+            pthread_mutex_lock(&bench_engine_lock);
+            int id = add_event("client", minute / 60, minute % 60, duration, 3);
+            pthread_mutex_unlock(&bench_engine_lock);
+            
+            pthread_mutex_lock(&bench_engine_lock);
+            remove_event(id);
+            pthread_mutex_unlock(&bench_engine_lock);
+        }
+    }
+    return NULL;
+}
+
+int run_pipeline_benchmark(int argc, char* argv[]) {
+    int producers = argc > 0 ? atoi(argv[0]) : 8;
+    int edits = argc > 1 ? atoi(argv[1]) : 50;
+    int window_us = argc > 2 ? atoi(argv[2]) : 0;
+    pthread_t threads[64];
+    PipelineProducerJob jobs[64];
+    
+    if (producers < 1) producers = 1;
+    if (producers > 64) producers = 64;
+    if (window_us < 0) window_us = 0;
+    verbose_output = false;
+    reschedule_budget_ms = 0;
+    
+    printf("=== MUTATION PIPELINE BENCHMARK (%d producers x %d edits, 300 base events, %d us window) ===\n",
+           producers, edits, window_us);
+    printf("%-14s %10s %12s %10s %12s %10s\n", "Mode", "Time(ms)", "Mutations/s", "Batches", "Avg batch",
+           "Coalesced");
+    printf("-------------------------------------------------------------------------\n");
+    
+    for (int mode = PRODUCER_MUTEX; mode <= PRODUCER_BURSTS; mode++) {
+        bool use_pipeline = mode != PRODUCER_MUTEX;
+        load_workload(&bench_workloads[1], 300, 42);
+        end_batch();
+        mutation_window_us = window_us;
+        if (use_pipeline) start_mutation_pipeline();
+        
+        double start = now_ms();
+        for (int p = 0; p < producers; p++) {
+            jobs[p].producer = p;
+            jobs[p].edits = edits;
+            jobs[p].mode = (ProducerMode)mode;
+            pthread_create(&threads[p], NULL, pipeline_producer_main, &jobs[p]);
+        }
+        for (int p = 0; p < producers; p++) {
+            pthread_join(threads[p], NULL);
+        }
+        double elapsed = now_ms() - start;
+        
+        long long mutations = (mode == PRODUCER_BURSTS ? 4LL : 2LL) * producers * edits;
+        if (use_pipeline) {
+            stop_mutation_pipeline();
+            printf("%-14s %10.1f %12.0f %10lld %12.1f %10lld\n", mode == PRODUCER_BURSTS ? "UI bursts" : "MPSC pipeline",
+                   elapsed, mutations / (elapsed / 1000), pipeline_batches,
+                   (double)pipeline_mutations / (pipeline_batches > 0 ? pipeline_batches : 1), pipeline_coalesced);
+        } else {
+            printf("%-14s %10.1f %12.0f %10lld %12.1f %10d\n", "global mutex", elapsed, mutations / (elapsed / 1000),
+                   mutations, 1.0, 0);
+        }
+    }
+    mutation_window_us = 0;
+    printf("=========================================================================\n");
+    
+    clear_all_events();
+    return 0;
+}
+
+void select_strategy() {
+    int choice;
+    printf("Current strategy: %s\n", strategy_name(scheduling_strategy));
+    printf("1. Priority greedy (honour priorities)\n");
+    printf("2. Earliest finish (maximise scheduled events)\n");
+    printf("3. Earliest finish across k rooms\n");
+    printf("Enter strategy: ");
+    scanf("%d", &choice);
+    
+    switch (choice) {
+        case 1: scheduling_strategy = STRATEGY_PRIORITY_GREEDY; break;
+        case 2: scheduling_strategy = STRATEGY_EARLIEST_FINISH; break;
+        case 3:
+            scheduling_strategy = STRATEGY_EARLIEST_FINISH_K;
+            printf("Enter number of rooms k (0 = one per registered room): ");
+            scanf("%d", &eft_room_count);
+            break;
+        default:
+            printf("Invalid strategy.\n");
+            return;
+    }
+    double began = trace_begin();
+    dynamic_reschedule();
+    trace_end(began, TRACE_RESCHEDULE, 0, 0, 0, 0, NULL);
+}
+
+void print_menu() {
+    printf("\n=== OPTIMIZED DYNAMIC EVENT SCHEDULER ===\n");
+    printf("1. Add Event\n");
+    printf("2. Remove Event\n");
+    printf("3. View Schedule\n");
+    printf("4. View All Events\n");
+    printf("5. View Conflict Graph\n");
+    printf("6. Manual Reschedule\n");
+    printf("7. Exit\n");
+    printf("8. Add Room\n");
+    printf("9. Set Event Room Requirements\n");
+    printf("10. View Room Assignment\n");
+    printf("11. Reassign All Rooms\n");
+    printf("12. Select Scheduling Strategy\n");
+    printf("13. Algorithm Selection (stats, cost model, forcing)\n");
+    printf("14. Set Reschedule Latency Budget\n");
+    printf("15. Find Free Slots\n");
+    printf("16. Update Event\n");
+    printf("17. Expire Past Events\n");
+    printf("18. Import iCalendar (.ics)\n");
+    printf("19. Export iCalendar (.ics)\n");
+    printf("20. Import Browser Storage (.json)\n");
+    printf("Enter your choice: ");
+}
+
+// Read scaling of the sharded id index:
+//   ./scheduler --bench-index [max threads] [ms per step]
+typedef struct {
+    atomic_bool* stop;
+    unsigned long long seed;
+    int num_ids;
+    bool use_lock;
+    long long lookups;
+    long long hits;
+} IndexReaderJob;
+
+pthread_mutex_t bench_index_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void* index_reader_main(void* arg) {
+    IndexReaderJob* job = (IndexReaderJob*)arg;
+    unsigned long long state = job->seed;
+    
+    while (!atomic_load_explicit(job->stop, memory_order_relaxed)) {
+        // Check the stop flag every 256 lookups to keep it out of the loop
+        for (int i = 0; i < 256; i++) {
+            int id = 1 + (int)(bench_random(&state) % (unsigned long long)job->num_ids);
+            int index;
+            if (job->use_lock) {
+                pthread_mutex_lock(&bench_index_lock);
+                index = find_event_index(id);
+                pthread_mutex_unlock(&bench_index_lock);
+            } else {
+                index = find_event_index(id);
+            }
+            job->hits += index >= 0;
+        }
+        job->lookups += 256;
+    }
+    return NULL;
+}
+
+// Churns the index the way remove_event()/add_event() do
+void* index_writer_main(void* arg) {
+    IndexReaderJob* job = (IndexReaderJob*)arg;
+    unsigned long long state = job->seed;
+    
+    while (!atomic_load_explicit(job->stop, memory_order_relaxed)) {
+        int id = 1 + (int)(bench_random(&state) % (unsigned long long)job->num_ids);
+        id_index_remove(id);
+        id_index_insert(id, id - 1);
+        job->lookups++;
+    }
+    return NULL;
+}
+
+int run_index_benchmark(int argc, char* argv[]) {
+    int max_threads = argc > 0 ? atoi(argv[0]) : 32;
+    double step_ms = argc > 1 ? atof(argv[1]) : 200;
+    const char* mode_names[] = {"global mutex", "lock-free", "lock-free+writer"};
+    pthread_t threads[MAX_SNAPSHOT_READERS + 1];
+    IndexReaderJob jobs[MAX_SNAPSHOT_READERS + 1];
+    atomic_bool stop;
+    
+    if (max_threads < 1) max_threads = 1;
+    if (max_threads > MAX_SNAPSHOT_READERS) max_threads = MAX_SNAPSHOT_READERS;
+    
+    for (int id = 1; id <= MAX_EVENTS; id++) {
+        id_index_insert(id, id - 1);
+    }
+    
+    printf("=== ID INDEX READ SCALING (%d ids, %d shards, %.0fms per step, %d CPUs) ===\n",
+           MAX_EVENTS, ID_INDEX_SHARDS, step_ms, (int)sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%-8s %-18s %14s %16s %12s\n", "Threads", "Mode", "Lookups/s", "Lookups/s/thread", "Writes");
+    printf("------------------------------------------------------------------------\n");
+    
+    for (int readers = 1; readers <= max_threads; readers *= 2) {
+        for (int mode = 0; mode < 3; mode++) {
+            int workers = readers + (mode == 2);
+            atomic_store(&stop, false);
+            
+            for (int r = 0; r < workers; r++) {
+                jobs[r].stop = &stop;
+                jobs[r].seed = 1000003ULL * (unsigned long long)(r + 1);
+                jobs[r].num_ids = MAX_EVENTS;
+                jobs[r].use_lock = mode == 0;
+                jobs[r].lookups = 0;
+                jobs[r].hits = 0;
+                pthread_create(&threads[r], NULL, r < readers ? index_reader_main : index_writer_main, &jobs[r]);
+            }
+            
+            double start = now_ms();
+            struct timespec step = {(time_t)(step_ms / 1000), (long)((long long)step_ms % 1000) * 1000000L};
+            nanosleep(&step, NULL);
+            atomic_store(&stop, true);
+            
+            long long total = 0;
+            long long writes = 0;
+            for (int r = 0; r < workers; r++) {
+                pthread_join(threads[r], NULL);
+                if (r < readers) total += jobs[r].lookups;
+                else writes = jobs[r].lookups;
+            }
+            double elapsed = (now_ms() - start) / 1000.0;
+            printf("%-8d %-18s %14.0f %16.0f %12lld\n", readers, mode_names[mode], total / elapsed,
+                   total / elapsed / readers, writes);
+        }
+    }
+    printf("========================================================================\n");
+    
+    id_index_clear();
+    return 0;
+}
+
+// Per-arrival booking latency, online mode against add_event():
+//   ./scheduler --bench-online [arrivals] [arrivals between passes]
+// Online passes run between arrivals and are reported separately.
+typedef struct {
+    int start;
+    int duration;
+    int priority;
+} Arrival;
+
+void print_latency_row(const char* mode, SortKey latencies[], SortKey scratch[], int count, const char* note) {
+    sort_keys(latencies, scratch, count);
+    printf("%-12s %8d %9.1f %9.1f %9.1f %10.1f  %s\n", mode, count,
+           latencies[count / 2].key / 1000.0, latencies[count * 9 / 10].key / 1000.0,
+           latencies[count * 99 / 100].key / 1000.0, latencies[count - 1].key / 1000.0, note);
+}
+
+long long elapsed_ns(const struct timespec* since) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since->tv_sec) * 1000000000LL + (now.tv_nsec - since->tv_nsec);
+}
+
+int run_online_benchmark(int argc, char* argv[]) {
+    static Arrival arrivals[MAX_EVENTS];
+    static SortKey latencies[MAX_EVENTS];
+    static SortKey scratch[MAX_EVENTS];
+    int n = argc > 0 ? atoi(argv[0]) : 2000;
+    int every = argc > 1 ? atoi(argv[1]) : 100;
+    unsigned long long state = 42;
+    char note[96];
+    
+    if (n < 1) n = 1;
+    if (n > MAX_EVENTS) n = MAX_EVENTS;
+    if (every < 1) every = 1;
+    verbose_output = false;
+    reschedule_budget_ms = 0;
+    
+    for (int k = 0; k < n; k++) {
+        arrivals[k].duration = 15 + (int)(bench_random(&state) % 106);
+        arrivals[k].start = 8 * 60 + (int)(bench_random(&state) % (10 * 60 - arrivals[k].duration));
+        arrivals[k].priority = 1 + (int)(bench_random(&state) % 5);
+    }
+    
+    printf("=== ONLINE BOOKING BENCHMARK (%d arrivals, 08:00-18:00, pass every %d) ===\n", n, every);
+    printf("%-12s %8s %9s %9s %9s %10s\n", "Mode", "Arrivals", "p50(us)", "p90(us)", "p99(us)", "max(us)");
+    printf("------------------------------------------------------------\n");
+    
+    clear_all_events();
+    online_begin();
+    int passes = 0;
+    double pass_ms = 0;
+    for (int k = 0; k < n; k++) {
+        struct timespec begin;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        online_add_event("arrival", arrivals[k].start / 60, arrivals[k].start % 60, arrivals[k].duration,
+                         arrivals[k].priority, NULL);
+        latencies[k].key = elapsed_ns(&begin);
+        latencies[k].index = k;
+        
+        if ((k + 1) % every == 0 || k == n - 1) {
+            double start = now_ms();
+            online_reoptimize();
+            pass_ms += now_ms() - start;
+            passes++;
+        }
+    }
+    snprintf(note, sizeof(note), "%lld on time, %lld moved, %lld unplaced; %d passes, %.2f ms avg",
+             online_accepted, online_moved, online_rejected, passes, pass_ms / passes);
+    online_end();
+    print_latency_row("online", latencies, scratch, n, note);
+    
+    clear_all_events();
+    for (int k = 0; k < n; k++) {
+        struct timespec begin;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        add_event("arrival", arrivals[k].start / 60, arrivals[k].start % 60, arrivals[k].duration,
+                  arrivals[k].priority);
+        latencies[k].key = elapsed_ns(&begin);
+        latencies[k].index = k;
+    }
+    print_latency_row("add_event", latencies, scratch, n, "graph rebuild and reschedule per arrival");
+    printf("============================================================\n");
+    
+    clear_all_events();
+    return 0;
+}
+
+// Timing wheel cost per operation, against scanning every timer each minute:
+//   ./scheduler --bench-timers [timers]
+void count_expired_timer(WheelTimer* timer, void* context) {
+    (void)timer;
+    (*(long long*)context)++;
+}
+
+int run_timer_benchmark(int argc, char* argv[]) {
+    int n = argc > 0 ? atoi(argv[0]) : 1000000;
+    if (n < 1) n = 1;
+    
+    WheelTimer* timers = (WheelTimer*)calloc((size_t)n, sizeof(WheelTimer));
+    int* expires = (int*)malloc((size_t)n * sizeof(int));
+    TimingWheel* wheel = (TimingWheel*)malloc(sizeof(TimingWheel));
+    unsigned long long state = 42;
+    long long fired = 0;
+    
+    for (int k = 0; k < n; k++) {
+        expires[k] = (int)(bench_random(&state) % (24 * 60));
+    }
+    wheel_init(wheel, 0);
+    
+    printf("=== TIMING WHEEL BENCHMARK (%d timers over one day) ===\n", n);
+    double start = now_ms();
+    for (int k = 0; k < n; k++) {
+        wheel_add(wheel, &timers[k], expires[k]);
+    }
+    double insert_ms = now_ms() - start;
+    
+    // Move every other timer, as a reschedule would
+    start = now_ms();
+    for (int k = 0; k < n; k += 2) {
+        wheel_cancel(wheel, &timers[k]);
+        expires[k] = (expires[k] + 30) % (24 * 60);
+        wheel_add(wheel, &timers[k], expires[k]);
+    }
+    double move_ms = now_ms() - start;
+    
+    start = now_ms();
+    wheel_advance(wheel, 24 * 60 - 1, count_expired_timer, &fired);
+    double day_ms = now_ms() - start;
+    
+    // Scan baseline: check every timer once a minute, timed over one hour
+    long long scanned = 0;
+    start = now_ms();
+    for (int minute = 0; minute < 60; minute++) {
+        for (int k = 0; k < n; k++) {
+            if (expires[k] == minute) scanned++;
+        }
+    }
+    double scan_day_ms = (now_ms() - start) * 24;
+    
+    printf("Insert:            %8.1f ns per timer\n", insert_ms * 1e6 / n);
+    printf("Cancel + re-add:   %8.1f ns per moved timer\n", move_ms * 1e6 / ((n + 1) / 2));
+    printf("Advance one day:   %8.2f ms, %lld fired (%.1f ns each)\n", day_ms, fired, day_ms * 1e6 / (fired > 0 ? fired : 1));
+    printf("Scan every minute: %8.2f ms per day (extrapolated from one hour, %lld due in it)\n", scan_day_ms, scanned);
+    printf("=======================================================\n");
+    
+    free(timers);
+    free(expires);
+    free(wheel);
+    return 0;
+}
+
+// Live working set and reschedule cost as the day's watermark advances:
+//   ./scheduler --bench-expiry [events] [seed]
+int run_expiry_benchmark(int argc, char* argv[]) {
+    int n = argc > 0 ? atoi(argv[0]) : 2000;
+    unsigned long long seed = argc > 1 ? strtoull(argv[1], NULL, 10) : 42;
+    
+    if (n < 1) n = 1;
+    if (n > MAX_EVENTS) n = MAX_EVENTS;
+    verbose_output = false;
+    reschedule_budget_ms = 0;
+    
+    load_workload(&bench_workloads[0], n, seed);
+    end_batch();
+    double start = now_ms();
     dynamic_reschedule();
+    double full_day_ms = now_ms() - start;
+    
+    printf("=== EXPIRY BENCHMARK (%d events over the whole day, seed %llu) ===\n", n, seed);
+    printf("Reschedule keeping every event: %.2f ms\n", full_day_ms);
+    printf("%-10s %8s %8s %10s %14s\n", "Watermark", "Live", "Evicted", "Evict(ms)", "Reschedule(ms)");
+    printf("------------------------------------------------------\n");
+    for (int watermark = 120; watermark < 24 * 60; watermark += 120) {
+        begin_batch();
+        start = now_ms();
+        int evicted = expire_events(watermark);
+        double evict_ms = now_ms() - start;
+        start = now_ms();
+        end_batch();
+        double reschedule_ms = now_ms() - start;
+        printf("%02d:%02d      %8d %8d %10.3f %14.2f\n", watermark / 60, watermark % 60, num_events, evicted,
+               evict_ms, reschedule_ms);
+    }
+    printf("======================================================\n");
+    
+    clear_all_events();
+    return 0;
+}
+
+// Empirical complexity of each pipeline phase over a grid of event counts,
+// overlap densities and worker counts:
+//   ./scheduler --bench-scaling [csv file] [seed] [max threads]
+// Density is the average number of events running at any minute. It is
+// held constant as n grows (durations shrink instead), so edges grow as
+// n * density and an O(n log n) phase fits an exponent near 1.1. Writes
+// one CSV row per phase and cell, then fits time ~ n^k per phase and
+// flags any k above the phase's limit. Exits 1 if anything was flagged.
+#define SCALING_PHASES 5
+#define SCALING_QUERIES 5000    // Per query-mix run; 1 in 10 is a free-slot search
+
+const char* scaling_phase_names[SCALING_PHASES] = {"build", "color", "greedy", "reschedule", "query"};
+const double scaling_phase_limits[SCALING_PHASES] = {1.5, 1.5, 1.5, 1.5, 0.5};   // n log n, and log n for queries
+
+// n events averaging `density` concurrent events across the whole day.
+// Leaves a batch open like load_workload().
+void load_density_workload(int n, int density, unsigned long long seed) {
+    unsigned long long state = seed * 2654435761ULL + 1;
+    int mean = 24 * 60 * density / n;
+    char name[50];
+    
+    if (mean < 1) mean = 1;
+    if (mean > 12 * 60) mean = 12 * 60;
+    int min_duration = (mean + 1) / 2;
+    int max_duration = mean + mean / 2;
+    
+    clear_all_events();
+    begin_batch();
+    for (int i = 0; i < n; i++) {
+        int duration = min_duration + (int)(bench_random(&state) % (unsigned int)(max_duration - min_duration + 1));
+        int start = (int)(bench_random(&state) % (unsigned int)(24 * 60 - duration));
+        int priority = 1 + (int)(bench_random(&state) % 5);
+        
+        snprintf(name, sizeof(name), "d%d-%d", density, i + 1);
+        add_event(name, start / 60, start % 60, duration, priority);
+    }
+}
+
+// Lookups of random ids and free-slot searches against the published
+// snapshot, the mix a read-heavy client sends
+void run_query_mix(int n, unsigned long long* state) {
+    int starts[MAX_TIME_SLOTS];
+    const ScheduleSnapshot* snapshot = snapshot_acquire();
+    for (int q = 0; q < SCALING_QUERIES; q++) {
+        if (q % 10 == 9) {
+            snapshot_find_free_slots(snapshot, 30 * (1 + (int)(bench_random(state) % 4)), starts, MAX_TIME_SLOTS);
+        } else {
+            snapshot_find_event(snapshot, 1 + (int)(bench_random(state) % (unsigned int)n));
+        }
+    }
+    snapshot_release();
+}
+
+// Least-squares slope of log(time) against log(n)
+double fit_exponent(const int sizes[], const double times[], int count) {
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    int used = 0;
+    for (int z = 0; z < count; z++) {
+        if (times[z] <= 0) continue;
+        double x = log(sizes[z]), y = log(times[z]);
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+        used++;
+    }
+    double det = used * sxx - sx * sx;
+    return used > 1 && det != 0 ? (used * sxy - sx * sy) / det : 0;
+}
+
+int run_scaling_benchmark(int argc, char* argv[]) {
+    const char* path = argc > 0 ? argv[0] : "scaling.csv";
+    unsigned long long seed = argc > 1 ? strtoull(argv[1], NULL, 10) : 42;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 4;
+    int sizes[] = {250, 500, 1000, 2000, 4000};
+    int densities[] = {4, 16, 64};
+    int thread_counts[] = {1, 2, 4, 8, 16, 32, 64};
+    const int num_sizes = (int)(sizeof(sizes) / sizeof(sizes[0]));
+    const int num_densities = (int)(sizeof(densities) / sizeof(densities[0]));
+    const int repetitions = 3;
+    static double times[3][7][SCALING_PHASES][5];   // [density][threads][phase][size], best ms
+    
+    int num_threads = 0;
+    while (num_threads < (int)(sizeof(thread_counts) / sizeof(thread_counts[0])) &&
+           thread_counts[num_threads] <= (max_threads > 0 ? max_threads : 1)) {
+        num_threads++;
+    }
+    
+    FILE* csv = fopen(path, "w");
+    if (csv == NULL) {
+        printf("Could not write %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    fprintf(csv, "density,n,threads,edges,phase,ms\n");
+    verbose_output = false;
+    reschedule_budget_ms = 0;
+    
+    printf("=== SCALING REPORT (seed %llu, best of %d, %d queries per mix) ===\n", seed, repetitions,
+           SCALING_QUERIES);
+    for (int d = 0; d < num_densities; d++) {
+        for (int t = 0; t < num_threads; t++) {
+            task_threads = thread_counts[t];
+            for (int z = 0; z < num_sizes; z++) {
+                double* best[SCALING_PHASES];
+                for (int p = 0; p < SCALING_PHASES; p++) {
+                    best[p] = &times[d][t][p][z];
+                    *best[p] = -1;
+                }
+                unsigned long long state = seed;
+                
+                for (int rep = 0; rep < repetitions; rep++) {
+                    double t_phase[SCALING_PHASES];
+                    load_density_workload(sizes[z], densities[d], seed);
+                    
+                    double start = now_ms();
+                    build_conflict_graph(NULL);
+                    t_phase[0] = now_ms() - start;
+                    
+                    start = now_ms();
+                    color_conflict_graph(NULL);
+                    t_phase[1] = now_ms() - start;
+                    
+                    start = now_ms();
+                    run_scheduling_strategy(STRATEGY_PRIORITY_GREEDY, NULL);
+                    t_phase[2] = now_ms() - start;
+                    
+                    // Closing the load batch is a full rebuild and reschedule
+                    start = now_ms();
+                    end_batch();
+                    t_phase[3] = now_ms() - start;
+                    
+                    start = now_ms();
+                    run_query_mix(sizes[z], &state);
+                    t_phase[4] = now_ms() - start;
+                    
+                    for (int p = 0; p < SCALING_PHASES; p++) {
+                        if (*best[p] < 0 || t_phase[p] < *best[p]) *best[p] = t_phase[p];
+                    }
+                }
+                
+                for (int p = 0; p < SCALING_PHASES; p++) {
+                    fprintf(csv, "%d,%d,%d,%lld,%s,%.4f\n", densities[d], sizes[z], thread_counts[t],
+                            schedule_stats.num_edges, scaling_phase_names[p], *best[p]);
+                }
+            }
+        }
+    }
+    fclose(csv);
+    
+    printf("Fitted k in time ~ n^k for n = %d..%d (limits: %.1f, queries %.1f)\n", sizes[0],
+           sizes[num_sizes - 1], scaling_phase_limits[0], scaling_phase_limits[SCALING_PHASES - 1]);
+    printf("%-8s %8s", "Density", "Threads");
+    for (int p = 0; p < SCALING_PHASES; p++) printf(" %11s", scaling_phase_names[p]);
+    printf("\n------------------------------------------------------------------------------\n");
+    
+    int flagged = 0;
+    for (int d = 0; d < num_densities; d++) {
+        for (int t = 0; t < num_threads; t++) {
+            printf("%-8d %8d", densities[d], thread_counts[t]);
+            for (int p = 0; p < SCALING_PHASES; p++) {
+                double k = fit_exponent(sizes, times[d][t][p], num_sizes);
+                bool over = k > scaling_phase_limits[p];
+                printf(" %10.2f%c", k, over ? '!' : ' ');
+                if (over) flagged++;
+            }
+            printf("\n");
+        }
+    }
+    printf("------------------------------------------------------------------------------\n");
+    if (flagged > 0) printf("%d fits above their limit (marked !): a phase has gone superlinear.\n", flagged);
+    printf("Wrote %s\n", path);
+    printf("==============================================================================\n");
+    
+    task_threads = 0;
+    clear_all_events();
+    return flagged > 0 ? 1 : 0;
+}
+
+// Performance regression gate: runs a fixed set of workloads and compares
+// each phase against a checked-in baseline:
+//   ./scheduler --gate [perf_baseline.txt] [--update]
+// Baseline lines are "workload phase metric value tolerance". Times (ms)
+// and allocations may exceed the baseline by their relative tolerance
+// (times also by GATE_TIME_SLACK_MS). The work counters (edges,
+// comparisons) are deterministic and must match exactly. Runs single
+// threaded with the built-in cost model and no latency budget, so the
+// counters do not depend on the machine. A workload with a slow time is
+// run a second time and its best times kept. --update rewrites the
+// baseline from this run. Exits 1 if anything regressed.
+#define GATE_REPETITIONS 5
+#define GATE_TIME_SLACK_MS 0.05      // Ignore sub-50 us jitter on tiny phases
+#define GATE_TIME_TOLERANCE 0.50
+#define GATE_ALLOC_TOLERANCE 0.10
+#define GATE_EDITS 20
+#define GATE_MAX_ENTRIES 256
+#define GATE_STEADY_OPERATIONS 100   // Per kind, for the per-operation allocation check
+
+typedef struct {
+    const Workload* workload;
+    int n;
+} GateWorkload;
+
+typedef enum {
+    GATE_LOAD,
+    GATE_BUILD,
+    GATE_COLOR,
+    GATE_SCHEDULE,
+    GATE_RESCHEDULE,
+    GATE_EDITS_PHASE,
+    GATE_QUERIES,
+    GATE_PIPELINE,
+    GATE_PHASES
+} GatePhase;
+
+typedef enum {
+    GATE_MS,
+    GATE_ALLOCATIONS,
+    GATE_EDGES,
+    GATE_COMPARISONS,
+    GATE_METRICS
+} GateMetric;
+
+const char* gate_phase_names[GATE_PHASES] = {"load", "build", "color", "schedule", "reschedule", "edits", "queries",
+                                           "pipeline"};
+const char* gate_metric_names[GATE_METRICS] = {"ms", "allocations", "edges", "comparisons"};
+
+typedef struct {
+    char workload[32];
+    char phase[16];
+    char metric[16];
+    double value;
+    double tolerance;
+} GateEntry;
+
+typedef struct {
+    double start_ms;
+    long long start[GATE_METRICS];
+} GateProbe;
+
+void gate_probe_begin(GateProbe* probe) {
+    probe->start[GATE_ALLOCATIONS] = atomic_load(&heap_allocations);
+    probe->start[GATE_EDGES] = atomic_load(&edges_built);
+    probe->start[GATE_COMPARISONS] = atomic_load(&overlap_tests);
+    probe->start_ms = now_ms();
+}
+
+// Times keep the best repetition; counts keep the last one, which runs
+// with warm pools like a long-lived server
+void gate_probe_end(const GateProbe* probe, double sample[GATE_METRICS], bool first) {
+    double ms = now_ms() - probe->start_ms;
+    sample[GATE_MS] = first || ms < sample[GATE_MS] ? ms : sample[GATE_MS];
+    sample[GATE_ALLOCATIONS] = (double)(atomic_load(&heap_allocations) - probe->start[GATE_ALLOCATIONS]);
+    sample[GATE_EDGES] = (double)(atomic_load(&edges_built) - probe->start[GATE_EDGES]);
+    sample[GATE_COMPARISONS] = (double)(atomic_load(&overlap_tests) - probe->start[GATE_COMPARISONS]);
+}
+
+// Moves, removals and re-adds, each followed by the usual reschedule
+void run_gate_edits(unsigned long long* state) {
+    for (int k = 0; k < GATE_EDITS; k++) {
+        const Event* event = &events[bench_random(state) % (unsigned int)num_events];
+        int start = (event_start_minutes(event) + 30) % (24 * 60 - event->duration_minutes);
+        char name[50];
+        strcpy(name, event->name);
+        if (k % 2 == 0) {
+            update_event(event->id, name, start / 60, start % 60, event->duration_minutes, event->priority);
+        } else {
+            int duration = event->duration_minutes, priority = event->priority;
+            remove_event(event->id);
+            add_event(name, start / 60, start % 60, duration, priority);
+        }
+    }
 }
 
-// Optimized remove event using hash table
-void remove_event(int event_id) {
-    int index = find_event_index(event_id);
-    
-    if (index == -1) {
-        printf("Event with ID %d not found.\n", event_id);
-        return;
+// The same kinds of edit submitted through the mutation pipeline, one at a
+// time so every batch holds a single request
+void run_gate_pipeline(unsigned long long* state) {
+    for (int k = 0; k < GATE_EDITS; k++) {
+        const Event* event = &events[bench_random(state) % (unsigned int)num_events];
+        int start = (event_start_minutes(event) + 30) % (24 * 60 - event->duration_minutes);
+        if (k % 2 == 0) {
+            mutation_wait(submit_update_event(event->id, event->name, start / 60, start % 60,
+                                              event->duration_minutes, event->priority), NULL);
+        } else {
+            int id = event->id;
+            mutation_wait(submit_add_event(event->name, start / 60, start % 60, event->duration_minutes,
+                                           event->priority), NULL);
+            mutation_wait(submit_remove_event(id), NULL);
+        }
     }
-    
-    printf("Removing event '%s' (ID: %d)\n", events[index].name, event_id);
-    
-    // Remove from hash table
-    hash_remove(event_id);
-    
-    // Shift remaining events
-    for (int i = index; i < num_events - 1; i++) {
-        events[i] = events[i + 1];
+}
+
+void run_gate_workload(const GateWorkload* gate, double samples[GATE_PHASES][GATE_METRICS]) {
+    for (int rep = 0; rep < GATE_REPETITIONS; rep++) {
+        GateProbe probe;
+        bool first = rep == 0;
+        unsigned long long state = 42;
+        
+        gate_probe_begin(&probe);
+        load_workload(gate->workload, gate->n, 42);
+        gate_probe_end(&probe, samples[GATE_LOAD], first);
+        
+        gate_probe_begin(&probe);
+        build_conflict_graph(NULL);
+        gate_probe_end(&probe, samples[GATE_BUILD], first);
+        
+        gate_probe_begin(&probe);
+        color_conflict_graph(NULL);
+        gate_probe_end(&probe, samples[GATE_COLOR], first);
+        
+        gate_probe_begin(&probe);
+        run_scheduling_strategy(STRATEGY_PRIORITY_GREEDY, NULL);
+        gate_probe_end(&probe, samples[GATE_SCHEDULE], first);
+        
+        gate_probe_begin(&probe);
+        end_batch();
+        gate_probe_end(&probe, samples[GATE_RESCHEDULE], first);
+        
+        gate_probe_begin(&probe);
+        run_gate_edits(&state);
+        gate_probe_end(&probe, samples[GATE_EDITS_PHASE], first);
+        
+        gate_probe_begin(&probe);
+        run_query_mix(gate->n, &state);
+        gate_probe_end(&probe, samples[GATE_QUERIES], first);
+        
+        start_mutation_pipeline();
+        gate_probe_begin(&probe);
+        run_gate_pipeline(&state);
+        gate_probe_end(&probe, samples[GATE_PIPELINE], first);
+        stop_mutation_pipeline();
     }
-    num_events--;
+}
+
+// Operations the steady-state check measures one at a time
+typedef enum {
+    GATE_OP_UPDATE,
+    GATE_OP_REMOVE,
+    GATE_OP_ADD,
+    GATE_OP_RESCHEDULE,
+    GATE_OP_LOOKUP,
+    GATE_OP_FREE_SLOTS,
+    GATE_OP_SUBMIT,
+    GATE_OPERATIONS
+} GateOperation;
+
+const char* gate_operation_names[GATE_OPERATIONS] = {"update", "remove", "add", "reschedule", "lookup",
+                                                     "free-slots", "submit"};
+
+typedef struct {
+    long long start;
+} GateAllocationProbe;
+
+void gate_allocation_begin(GateAllocationProbe* probe) {
+    probe->start = atomic_load(&heap_allocations);
+}
+
+void gate_allocation_end(const GateAllocationProbe* probe, long long worst[GATE_OPERATIONS], GateOperation op) {
+    long long made = atomic_load(&heap_allocations) - probe->start;
+    if (made > worst[op]) worst[op] = made;
+}
+
+// With the pools warmed by run_gate_workload(), count the allocations of
+// every individual edit, reschedule, query and pipeline submit, keeping
+// the worst of each kind. The phase totals can hide an operation that
+// allocates and a later one that frees; this cannot.
+void run_gate_steady_state(unsigned long long* state, long long worst[GATE_OPERATIONS]) {
+    GateAllocationProbe probe;
+    int starts[MAX_TIME_SLOTS];
+    char name[50];
+    memset(worst, 0, sizeof(long long) * GATE_OPERATIONS);
     
-    // Update hash table indices
-    for (int i = 0; i < HASH_SIZE; i++) {
-        HashNode* current = conflict_graph.event_hash[i];
-        while (current != NULL) {
-            if (current->event_index > index) {
-                current->event_index--;
-            }
-            current = current->next;
-        }
+    for (int k = 0; k < GATE_STEADY_OPERATIONS; k++) {
+        const Event* event = &events[bench_random(state) % (unsigned int)num_events];
+        int id = event->id, duration = event->duration_minutes, priority = event->priority;
+        int start = (event_start_minutes(event) + 30) % (24 * 60 - duration);
+        strcpy(name, event->name);
+        
+        gate_allocation_begin(&probe);
+        update_event(id, name, start / 60, start % 60, duration, priority);
+        gate_allocation_end(&probe, worst, GATE_OP_UPDATE);
+        
+        gate_allocation_begin(&probe);
+        remove_event(id);
+        gate_allocation_end(&probe, worst, GATE_OP_REMOVE);
+        
+        gate_allocation_begin(&probe);
+        add_event(name, start / 60, start % 60, duration, priority);
+        gate_allocation_end(&probe, worst, GATE_OP_ADD);
+        
+        gate_allocation_begin(&probe);
+        dynamic_reschedule();
+        gate_allocation_end(&probe, worst, GATE_OP_RESCHEDULE);
+        
+        gate_allocation_begin(&probe);
+        const ScheduleSnapshot* snapshot = snapshot_acquire();
+        snapshot_find_event(snapshot, events[bench_random(state) % (unsigned int)num_events].id);
+        snapshot_release();
+        gate_allocation_end(&probe, worst, GATE_OP_LOOKUP);
+        
+        gate_allocation_begin(&probe);
+        snapshot = snapshot_acquire();
+        snapshot_find_free_slots(snapshot, 30 * (1 + (int)(bench_random(state) % 4)), starts, MAX_TIME_SLOTS);
+        snapshot_release();
+        gate_allocation_end(&probe, worst, GATE_OP_FREE_SLOTS);
     }
     
-    // Rebuild and reschedule
-    build_conflict_graph();
-    dynamic_reschedule();
-}
-
-// Helper functions remain largely the same but optimized where possible
-int get_time_slot(int hour, int minute) {
-    return (hour * 60 + minute) / 30;
+    start_mutation_pipeline();
+    for (int k = 0; k < GATE_STEADY_OPERATIONS; k++) {
+        const Event* event = &events[bench_random(state) % (unsigned int)num_events];
+        int start = (event_start_minutes(event) + 30) % (24 * 60 - event->duration_minutes);
+        strcpy(name, event->name);
+        
+        gate_allocation_begin(&probe);
+        mutation_wait(submit_update_event(event->id, name, start / 60, start % 60, event->duration_minutes,
+                                          event->priority), NULL);
+        gate_allocation_end(&probe, worst, GATE_OP_SUBMIT);
+    }
+    stop_mutation_pipeline();
 }
 
-TimeSlot get_time_from_slot(int slot) {
-    TimeSlot time;
-    int total_minutes = slot * 30;
-    time.start_hour = total_minutes / 60;
-    time.start_minute = total_minutes % 60;
-    time.end_hour = (total_minutes + 30) / 60;
-    time.end_minute = (total_minutes + 30) % 60;
-    return time;
+int load_gate_baseline(const char* path, GateEntry entries[], int max_entries) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) return -1;
+    
+    char line[256];
+    int count = 0;
+    while (fgets(line, sizeof(line), file) != NULL && count < max_entries) {
+        GateEntry* entry = &entries[count];
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%31s %15s %15s %lf %lf", entry->workload, entry->phase, entry->metric, &entry->value,
+                   &entry->tolerance) == 5) {
+            count++;
+        }
+    }
+    fclose(file);
+    return count;
 }
 
-bool can_schedule_at_time(int event_id, TimeSlot time) {
-    for (int i = 0; i < num_events; i++) {
-        if (events[i].id != event_id && events[i].scheduled && 
-            check_time_conflict(time, events[i].time)) {
-            return false;
+const GateEntry* find_gate_entry(const GateEntry entries[], int count, const char* workload, const char* phase,
+                                 const char* metric) {
+    for (int k = 0; k < count; k++) {
+        if (strcmp(entries[k].workload, workload) == 0 && strcmp(entries[k].phase, phase) == 0 &&
+            strcmp(entries[k].metric, metric) == 0) {
+            return &entries[k];
         }
     }
-    return true;
+    return NULL;
 }
 
-void dynamic_reschedule() {
-    printf("\n=== DYNAMIC RESCHEDULING ===\n");
-    
-    greedy_interval_scheduling();
+int run_regression_gate(int argc, char* argv[]) {
+    static GateEntry baseline[GATE_MAX_ENTRIES];
+    static double samples[GATE_PHASES][GATE_METRICS];
+    const GateWorkload workloads[] = {
+        {&bench_workloads[0], 2000},
+        {&bench_workloads[1], 1000},
+        {&bench_workloads[2], 500},
+    };
+    const char* path = "perf_baseline.txt";
+    bool update = false;
+    heap_counting = true;
+    for (int k = 0; k < argc; k++) {
+        if (strcmp(argv[k], "--update") == 0) update = true;
+        else path = argv[k];
+    }
     
-    int unscheduled_count = 0;
-    for (int i = 0; i < num_events; i++) {
-        if (!events[i].scheduled) {
-            unscheduled_count++;
+    int entries = 0;
+    if (!update) {
+        entries = load_gate_baseline(path, baseline, GATE_MAX_ENTRIES);
+        if (entries < 0) {
+            printf("Could not read baseline %s: %s (create it with --gate %s --update)\n", path, strerror(errno),
+                   path);
+            return 1;
+        }
+    }
+    FILE* out = NULL;
+    if (update) {
+        out = fopen(path, "w");
+        if (out == NULL) {
+            printf("Could not write baseline %s: %s\n", path, strerror(errno));
+            return 1;
         }
+        fprintf(out, "# Regression gate baseline, written by ./scheduler --gate %s --update\n", path);
+        fprintf(out, "# workload phase metric value tolerance (relative; counters must match exactly)\n");
     }
     
-    if (unscheduled_count > 0) {
-        printf("Warning: %d events could not be scheduled due to conflicts!\n", unscheduled_count);
+    CostModel defaults = COST_MODEL_DEFAULTS;
+    cost_model = defaults;
+    forced_graph_build = GRAPH_BUILD_AUTO;
+    forced_coloring = COLORING_AUTO;
+    forced_graph_mode = GRAPH_MODE_AUTO;
+    verbose_output = false;
+    reschedule_budget_ms = 0;
+    task_threads = 1;
+    
+    printf("=== REGRESSION GATE (%s%s, best of %d) ===\n", path, update ? ", updating" : "", GATE_REPETITIONS);
+    printf("%-12s %-10s %-12s %12s %12s %12s  %s\n", "Workload", "Phase", "Metric", "Baseline", "Current",
+           "Limit", "Result");
+    printf("------------------------------------------------------------------------------------\n");
+    
+    int failures = 0, missing = 0;
+    char failed[16][96];
+    for (int w = 0; w < (int)(sizeof(workloads) / sizeof(workloads[0])); w++) {
+        char name[32];
+        snprintf(name, sizeof(name), "%s-%d", workloads[w].workload->name, workloads[w].n);
+        graph_edits = graph_uses = 0;
+        run_gate_workload(&workloads[w], samples);
         
-        welsh_powell_coloring();
+        // A slow time is confirmed by a second run before it counts
+        bool slow = false;
+        for (int p = 0; p < GATE_PHASES && !update; p++) {
+            const GateEntry* entry = find_gate_entry(baseline, entries, name, gate_phase_names[p], "ms");
+            if (entry != NULL && samples[p][GATE_MS] > entry->value * (1 + entry->tolerance) + GATE_TIME_SLACK_MS) {
+                slow = true;
+            }
+        }
+        if (slow) {
+            static double retry[GATE_PHASES][GATE_METRICS];
+            graph_edits = graph_uses = 0;
+            run_gate_workload(&workloads[w], retry);
+            for (int p = 0; p < GATE_PHASES; p++) {
+                if (retry[p][GATE_MS] < samples[p][GATE_MS]) samples[p][GATE_MS] = retry[p][GATE_MS];
+            }
+        }
         
-        // Try alternative scheduling for unscheduled events
-        for (int i = 0; i < num_events; i++) {
-            if (!events[i].scheduled) {
-                bool rescheduled = false;
-                for (int slot = 0; slot < MAX_TIME_SLOTS - (events[i].duration_minutes / 30); slot++) {
-                    TimeSlot alternative_time = get_time_from_slot(slot);
-                    alternative_time.end_hour = (alternative_time.start_hour * 60 + 
-                                               alternative_time.start_minute + 
-                                               events[i].duration_minutes) / 60;
-                    alternative_time.end_minute = (alternative_time.start_hour * 60 + 
-                                                  alternative_time.start_minute + 
-                                                  events[i].duration_minutes) % 60;
-                    
-                    if (can_schedule_at_time(events[i].id, alternative_time)) {
-                        events[i].time = alternative_time;
-                        events[i].scheduled = true;
-                        events[i].color = slot;
-                        printf("Rescheduled '%s' to alternative time: %02d:%02d-%02d:%02d\n", 
-                               events[i].name, alternative_time.start_hour, alternative_time.start_minute,
-                               alternative_time.end_hour, alternative_time.end_minute);
-                        rescheduled = true;
-                        break;
-                    }
+        // Every single operation must be allocation-free, baseline or not
+        long long worst[GATE_OPERATIONS];
+        unsigned long long state = 7;
+        run_gate_steady_state(&state, worst);
+        for (int op = 0; op < GATE_OPERATIONS && !update; op++) {
+            bool ok = worst[op] == 0;
+            printf("%-12s %-10s %-12s %12.3f %12.3f %12.3f  %s\n", name, "per-op", gate_operation_names[op], 0.0,
+                   (double)worst[op], 0.0, ok ? "ok" : "ALLOCATED");
+            if (!ok) {
+                if (failures < 16) {
+                    snprintf(failed[failures], sizeof(failed[failures]), "per-op on %s: one %s made %lld allocations",
+                             name, gate_operation_names[op], worst[op]);
+                }
+                failures++;
+            }
+        }
+        
+        for (int p = 0; p < GATE_PHASES; p++) {
+            for (int m = 0; m < GATE_METRICS; m++) {
+                double current = samples[p][m];
+                bool counter = m == GATE_EDGES || m == GATE_COMPARISONS;
+                if (update) {
+                    double tolerance = m == GATE_MS ? GATE_TIME_TOLERANCE : m == GATE_ALLOCATIONS ?
+                                       GATE_ALLOC_TOLERANCE : 0;
+                    fprintf(out, "%s %s %s %.4f %.2f\n", name, gate_phase_names[p], gate_metric_names[m], current,
+                            tolerance);
+                    continue;
                 }
                 
-                if (!rescheduled) {
-                    printf("Could not find alternative time slot for '%s'\n", events[i].name);
+                const GateEntry* entry = find_gate_entry(baseline, entries, name, gate_phase_names[p],
+                                                         gate_metric_names[m]);
+                if (entry == NULL) {
+                    printf("%-12s %-10s %-12s %12s %12.3f %12s  new\n", name, gate_phase_names[p],
+                           gate_metric_names[m], "-", current, "-");
+                    missing++;
+                    continue;
+                }
+                double limit = counter ? entry->value : entry->value * (1 + entry->tolerance) +
+                               (m == GATE_MS ? GATE_TIME_SLACK_MS : 0);
+                bool ok = counter ? current == entry->value : current <= limit;
+                if (ok && current == 0 && entry->value == 0) continue;   // Work this phase never does
+                const char* result = ok ? "ok" : counter ? "CHANGED" : "REGRESSED";
+                if (ok && !counter && m == GATE_MS && current < entry->value / (1 + entry->tolerance)) {
+                    result = "ok (faster)";
+                }
+                printf("%-12s %-10s %-12s %12.3f %12.3f %12.3f  %s\n", name, gate_phase_names[p],
+                       gate_metric_names[m], entry->value, current, limit, result);
+                if (!ok) {
+                    if (failures < 16) {
+                        snprintf(failed[failures], sizeof(failed[failures]), "%s on %s: %s %.3f -> %.3f",
+                                 gate_phase_names[p], name, gate_metric_names[m], entry->value, current);
+                    }
+                    failures++;
                 }
             }
         }
     }
+    printf("------------------------------------------------------------------------------------\n");
     
-    printf("Rescheduling complete.\n");
-    printf("========================\n\n");
+    task_threads = 0;
+    clear_all_events();
+    if (update) {
+        fclose(out);
+        printf("Wrote baseline %s\n", path);
+        return 0;
+    }
+    if (missing > 0) printf("%d metrics have no baseline entry; add them with --update.\n", missing);
+    if (failures == 0) {
+        printf("PASS: no phase regressed.\n");
+        return 0;
+    }
+    printf("FAIL: %d regressions\n", failures);
+    for (int k = 0; k < failures && k < 16; k++) {
+        printf("  REGRESSION %s\n", failed[k]);
+    }
+    printf("Counters must match exactly; if a change is intended, rerun with --update and commit the baseline.\n");
+    return 1;
 }
 
-void print_graph() {
-    printf("\n=== CONFLICT GRAPH ===\n");
-    for (int i = 0; i < num_events; i++) {
-        printf("Event %d (%s, degree=%d): ", events[i].id, events[i].name, events[i].degree);
-        AdjListNode* current = conflict_graph.adjacency_list[i];
-        while (current != NULL) {
-            printf("%d ", events[current->event_index].id);
-            current = current->next;
-        }
-        printf("\n");
+// Re-execute a --trace capture against this build and report what each
+// kind of call cost:
+//   ./scheduler --replay trace [speed]
+// speed 0 (default) replays back to back, 1 at the recorded pace, N at N
+// times it. Ids are mapped from the trace to the ones this run hands out.
+typedef struct {
+    long long* latencies;     // ns, one per call
+    int count;
+    int capacity;
+    long long total_ns;
+} ReplayOpStats;
+
+const char* trace_op_name(int op) {
+    switch (op) {
+        case TRACE_ADD: return "add";
+        case TRACE_REMOVE: return "remove";
+        case TRACE_UPDATE: return "update";
+        case TRACE_REQUIREMENTS: return "requirements";
+        case TRACE_ADD_ROOM: return "add_room";
+        case TRACE_EXPIRE: return "expire";
+        case TRACE_BEGIN_BATCH: return "begin_batch";
+        case TRACE_END_BATCH: return "end_batch";
+        case TRACE_RESCHEDULE: return "reschedule";
+        case TRACE_CONFIG: return "config";
+        case TRACE_LOOKUP: return "lookup";
+        case TRACE_FREE_SLOTS: return "free_slots";
+        case TRACE_CLEAR: return "clear";
+        case TRACE_ONLINE_BEGIN: return "online_begin";
+        case TRACE_ONLINE_ADD: return "online_add";
+        case TRACE_ONLINE_REMOVE: return "online_remove";
+        case TRACE_ONLINE_REOPTIMIZE: return "online_reopt";
+        case TRACE_ONLINE_END: return "online_end";
+        default: return "unknown";
     }
-    printf("====================\n\n");
 }
 
-void print_schedule() {
-    printf("\n=== CURRENT SCHEDULE ===\n");
-    printf("%-4s %-20s %-12s %-8s %-8s %-10s\n", 
-           "ID", "Event Name", "Time", "Duration", "Priority", "Status");
-    printf("------------------------------------------------------------\n");
-    
-    for (int i = 0; i < num_events; i++) {
-        printf("%-4d %-20s %02d:%02d-%02d:%02d %-8d %-8d %-10s\n",
-               events[i].id,
-               events[i].name,
-               events[i].time.start_hour, events[i].time.start_minute,
-               events[i].time.end_hour, events[i].time.end_minute,
-               events[i].duration_minutes,
-               events[i].priority,
-               events[i].scheduled ? "Scheduled" : "Unscheduled");
+int compare_long_long(const void* a, const void* b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+int* replay_id_map = NULL;    // Trace id -> id in this run, 0 = never added
+int replay_id_capacity = 0;
+
+void replay_map_id(int trace_id, int id) {
+    if (trace_id <= 0 || id <= 0) return;
+    if (trace_id >= replay_id_capacity) {
+        int capacity = replay_id_capacity > 0 ? replay_id_capacity : 1024;
+        while (capacity <= trace_id) capacity *= 2;
+        replay_id_map = (int*)realloc(replay_id_map, (size_t)capacity * sizeof(int));
+        memset(replay_id_map + replay_id_capacity, 0, (size_t)(capacity - replay_id_capacity) * sizeof(int));
+        replay_id_capacity = capacity;
     }
-    printf("========================================\n\n");
+    replay_id_map[trace_id] = id;
 }
 
-void print_events() {
-    printf("\n=== ALL EVENTS ===\n");
+int replay_lookup_id(int trace_id) {
+    if (trace_id > 0 && trace_id < replay_id_capacity && replay_id_map[trace_id] > 0) return replay_id_map[trace_id];
+    return -1;
+}
+
+void replay_call(const TraceRecord* record, char* name) {
+    const int32_t* a = record->args;
+    switch (record->op) {
+        case TRACE_ADD:
+            replay_map_id(a[0], add_event(name, a[1] / 60, a[1] % 60, a[2], a[3]));
+            break;
+        case TRACE_REMOVE:
+            remove_event(replay_lookup_id(a[0]));
+            break;
+        case TRACE_UPDATE:
+            update_event(replay_lookup_id(a[0]), name, a[1] / 60, a[1] % 60, a[2], a[3]);
+            break;
+        case TRACE_REQUIREMENTS:
+            set_event_requirements(replay_lookup_id(a[0]), a[1], (unsigned int)a[2]);
+            break;
+        case TRACE_ADD_ROOM:
+            add_room(name, a[0], (unsigned int)a[1]);
+            break;
+        case TRACE_EXPIRE:
+            expire_events(a[0]);
+            break;
+        case TRACE_BEGIN_BATCH:
+            begin_batch();
+            break;
+        case TRACE_END_BATCH:
+            end_batch();
+            break;
+        case TRACE_RESCHEDULE:
+            dynamic_reschedule();
+            break;
+        case TRACE_CONFIG:
+            scheduling_strategy = (SchedulingStrategy)a[0];
+            eft_room_count = a[1];
+            reschedule_budget_ms = a[2] / 1000.0;
+            break;
+        case TRACE_LOOKUP:
+        case TRACE_FREE_SLOTS: {
+            int starts[MAX_TIME_SLOTS];
+            const ScheduleSnapshot* snapshot = snapshot_acquire();
+            if (snapshot != NULL) {
+                if (record->op == TRACE_LOOKUP) snapshot_find_event(snapshot, replay_lookup_id(a[0]));
+                else snapshot_find_free_slots(snapshot, a[0], starts, MAX_TIME_SLOTS);
+            }
+            snapshot_release();
+            break;
+        }
+        case TRACE_CLEAR:
+            clear_all_events();
+            break;
+        case TRACE_ONLINE_BEGIN:
+            online_begin();
+            break;
+        case TRACE_ONLINE_ADD:
+            replay_map_id(a[0], online_add_event(name, a[1] / 60, a[1] % 60, a[2], a[3], NULL));
+            break;
+        case TRACE_ONLINE_REMOVE:
+            online_remove_event(replay_lookup_id(a[0]));
+            break;
+        case TRACE_ONLINE_REOPTIMIZE:
+            online_reoptimize();
+            break;
+        case TRACE_ONLINE_END:
+            online_end();
+            break;
+    }
+}
+
+int run_replay(int argc, char* argv[]) {
+    static ReplayOpStats stats[TRACE_OP_COUNT];
+    if (argc < 1) {
+        printf("Usage: ./scheduler --replay trace [speed]\n");
+        return 1;
+    }
+    double speed = argc > 1 ? atof(argv[1]) : 0;
+    FILE* in = fopen(argv[0], "rb");
+    if (in == NULL) {
+        printf("Could not open trace %s: %s\n", argv[0], strerror(errno));
+        return 1;
+    }
+    
+    TraceHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != TRACE_MAGIC ||
+        header.version != TRACE_VERSION) {
+        printf("%s is not a version %d trace.\n", argv[0], TRACE_VERSION);
+        fclose(in);
+        return 1;
+    }
+    verbose_output = false;
+    scheduling_strategy = (SchedulingStrategy)header.strategy;
+    eft_room_count = header.eft_room_count;
+    reschedule_budget_ms = header.budget_us / 1000.0;
+    
+    TraceRecord record;
+    char name[256];
+    long long trace_us = 0;
+    long long calls = 0;
+    long long max_lag_ns = 0;
+    bool truncated = false;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    while (fread(&record, sizeof(record), 1, in) == 1) {
+        if (record.name_len > 0 && fread(name, 1, record.name_len, in) != record.name_len) {
+            truncated = true;
+            break;
+        }
+        name[record.name_len < 49 ? record.name_len : 49] = '\0';   // Event and room names are char[50]
+        trace_us += record.delta_us;
+        if (record.op == 0 || record.op >= TRACE_OP_COUNT) continue;
+        
+        if (speed > 0) {
+            long long due = (long long)(trace_us * 1000 / speed);
+            long long now = elapsed_ns(&start);
+            if (due > now) {
+                struct timespec pause = {(time_t)((due - now) / 1000000000), (long)((due - now) % 1000000000)};
+                nanosleep(&pause, NULL);
+            } else if (now - due > max_lag_ns) {
+                max_lag_ns = now - due;
+            }
+        }
+        
+        struct timespec begin;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        replay_call(&record, name);
+        long long ns = elapsed_ns(&begin);
+        
+        ReplayOpStats* op = &stats[record.op];
+        if (op->count == op->capacity) {
+            op->capacity = op->capacity > 0 ? op->capacity * 2 : 256;
+            op->latencies = (long long*)realloc(op->latencies, (size_t)op->capacity * sizeof(long long));
+        }
+        op->latencies[op->count++] = ns;
+        op->total_ns += ns;
+        calls++;
+    }
+    fclose(in);
+    double wall_ms = elapsed_ns(&start) / 1e6;
+    
+    int scheduled = 0;
     for (int i = 0; i < num_events; i++) {
-        printf("ID: %d, Name: %s, Time: %02d:%02d-%02d:%02d, Duration: %d min, Priority: %d\n",
-               events[i].id, events[i].name,
-               events[i].time.start_hour, events[i].time.start_minute,
-               events[i].time.end_hour, events[i].time.end_minute,
-               events[i].duration_minutes, events[i].priority);
+        if (events[i].scheduled) scheduled++;
     }
-    printf("==================\n\n");
+    
+    printf("=== TRACE REPLAY (%s, %lld calls over %.2f s recorded, ", argv[0], calls, trace_us / 1e6);
+    if (speed > 0) printf("%gx speed) ===\n", speed);
+    else printf("back to back) ===\n");
+    if (truncated) printf("Trace ends mid-record; replayed the complete records.\n");
+    printf("%-14s %8s %10s %9s %9s %9s %10s\n", "Call", "Count", "Calls/s", "p50(us)", "p99(us)", "max(us)",
+           "Busy(ms)");
+    printf("------------------------------------------------------------------------\n");
+    for (int op = 1; op < TRACE_OP_COUNT; op++) {
+        ReplayOpStats* s = &stats[op];
+        if (s->count == 0) continue;
+        qsort(s->latencies, (size_t)s->count, sizeof(long long), compare_long_long);
+        printf("%-14s %8d %10.0f %9.1f %9.1f %9.1f %10.2f\n", trace_op_name(op), s->count,
+               s->count / (s->total_ns > 0 ? s->total_ns / 1e9 : 1e-9), s->latencies[s->count / 2] / 1000.0,
+               s->latencies[(long long)s->count * 99 / 100] / 1000.0, s->latencies[s->count - 1] / 1000.0,
+               s->total_ns / 1e6);
+        free(s->latencies);
+        s->latencies = NULL;
+        s->count = s->capacity = 0;
+        s->total_ns = 0;
+    }
+    printf("------------------------------------------------------------------------\n");
+    printf("Replayed in %.2f ms: %.0f calls/s", wall_ms, calls / (wall_ms > 0 ? wall_ms / 1000 : 1e-9));
+    if (speed > 0) printf(", at most %.2f ms behind the trace", max_lag_ns / 1e6);
+    printf("\nFinal state: %d events, %d scheduled\n", num_events, scheduled);
+    printf("========================================================================\n");
+    
+    free(replay_id_map);
+    replay_id_map = NULL;
+    replay_id_capacity = 0;
+    clear_all_events();
+    return truncated ? 1 : 0;
 }
 
-void print_menu() {
-    printf("\n=== OPTIMIZED DYNAMIC EVENT SCHEDULER ===\n");
-    printf("1. Add Event\n");
-    printf("2. Remove Event\n");
-    printf("3. View Schedule\n");
-    printf("4. View All Events\n");
-    printf("5. View Conflict Graph\n");
-    printf("6. Manual Reschedule\n");
-    printf("7. Exit\n");
-    printf("Enter your choice: ");
+// A --ics or --json file named before the mode, imported in command-line order
+#define MAX_STARTUP_IMPORTS 16
+
+typedef struct {
+    bool json;
+    const char* path;
+    int day;            // YYYYMMDD argument, ICS_NO_DAY for every event
+} StartupImport;
+
+bool run_startup_import(const StartupImport* import) {
+    double began = now_ms();
+    if (!import->json) {
+        IcsImportStats stats;
+        if (!import_ics(import->path, import->day, &stats)) {
+            fprintf(stderr, "Cannot open %s\n", import->path);
+            return false;
+        }
+        print_ics_import(import->path, &stats, now_ms() - began);
+        return true;
+    }
+    
+    BrowserImportStats stats;
+    long long error_offset;
+    if (!import_browser_storage(import->path, import->day, &stats, &error_offset)) {
+        if (error_offset < 0) {
+            fprintf(stderr, "Cannot open %s\n", import->path);
+        } else {
+            fprintf(stderr, "Malformed JSON in %s near byte %lld\n", import->path, error_offset);
+        }
+        return false;
+    }
+    print_browser_import(import->path, &stats, now_ms() - began);
+    return true;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    load_cost_model("cost_model.txt");
+    
+    // Options that apply to any mode come before it, in any order. All of
+    // them are read first; then the outputs are set up and the imports run,
+    // so imported events are traced, retained and published like the rest.
+    const char* shm_path = NULL;        // --shm [/name]: publish to shared memory
+    bool retain = false;                // --retain [archive]: evict ended events
+    const char* archive = NULL;
+    const char* trace_path = NULL;      // --trace file: record API calls for --replay
+    bool notify = false;                // --notify [lead minutes]: print notifications
+    StartupImport imports[MAX_STARTUP_IMPORTS];   // --ics / --json file [YYYYMMDD]
+    int num_imports = 0;
+    int arg = 1;
+    for (; arg < argc; arg++) {
+        bool has_value = arg + 1 < argc;
+        if (strcmp(argv[arg], "--shm") == 0) {
+            shm_path = has_value && argv[arg + 1][0] == '/' ? argv[++arg] : SCHED_SHM_DEFAULT_NAME;
+        } else if (strcmp(argv[arg], "--retain") == 0) {
+            retain = true;
+            if (has_value && strncmp(argv[arg + 1], "--", 2) != 0) archive = argv[++arg];
+        } else if (strcmp(argv[arg], "--trace") == 0 && has_value) {
+            trace_path = argv[++arg];
+        } else if (strcmp(argv[arg], "--notify") == 0) {
+            notify = true;
+            if (has_value && argv[arg + 1][0] >= '0' && argv[arg + 1][0] <= '9') {
+                reminder_lead_minutes = atoi(argv[++arg]);
+            }
+        } else if ((strcmp(argv[arg], "--ics") == 0 || strcmp(argv[arg], "--json") == 0) && has_value &&
+                   num_imports < MAX_STARTUP_IMPORTS) {
+            StartupImport* import = &imports[num_imports++];
+            import->json = strcmp(argv[arg], "--json") == 0;
+            import->path = argv[++arg];
+            import->day = ICS_NO_DAY;
+            if (arg + 1 < argc && argv[arg + 1][0] >= '0' && argv[arg + 1][0] <= '9') {
+                import->day = parse_ics_day_argument(argv[++arg]);
+            }
+        } else {
+            break;
+        }
+    }
+    argv[arg - 1] = argv[0];
+    argv += arg - 1;
+    argc -= arg - 1;
+    
+    if (shm_path != NULL) {
+        if (!shm_enable(shm_path)) return 1;
+        atexit(shm_disable);
+    }
+    if (retain) {
+        if (!retention_enable(archive)) return 1;
+        atexit(retention_disable);
+    }
+    if (trace_path != NULL) {
+        if (!trace_enable(trace_path)) return 1;
+        atexit(trace_disable);
+    }
+    if (notify) notifications_enable(print_notification, NULL, wall_clock_minute());
+    for (int k = 0; k < num_imports; k++) {
+        if (!run_startup_import(&imports[k])) return 1;
+    }
+    
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        return run_benchmarks(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--calibrate") == 0) {
+        return run_calibration(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-placement") == 0) {
+        return run_placement_benchmark(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-tasks") == 0) {
+        return run_task_benchmark(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-snapshot") == 0) {
+        return run_snapshot_benchmark(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-pipeline") == 0) {
+        return run_pipeline_benchmark(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--serve") == 0) {
+        return run_rpc_server(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-index") == 0) {
+        return run_index_benchmark(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--shm-read") == 0) {
+        return run_shm_reader(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-expiry") == 0) {
+        return run_expiry_benchmark(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-timers") == 0) {
+        return run_timer_benchmark(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-online") == 0) {
+        return run_online_benchmark(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-scaling") == 0) {
+        return run_scaling_benchmark(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--gate") == 0) {
+        return run_regression_gate(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--replay") == 0) {
+        return run_replay(argc - 2, argv + 2);
+    }
+    
     printf("Welcome to Optimized Dynamic Event Scheduler!\n");
     printf("This program demonstrates OPTIMIZED:\n");
     printf("- Graph Coloring (Welsh-Powell with Merge Sort)\n");
     printf("- Greedy Interval Scheduling (with Merge Sort)\n");
-    printf("- Hash Table for O(1) Event Lookup\n");
+    printf("- Sharded Id Index with Lock-Free Lookups\n");
     printf("- Adjacency List instead of Matrix\n");
     printf("- Precomputed Degrees\n\n");
     
@@ -570,6 +8049,7 @@ int main() {
     
     int choice;
     do {
+        clock_tick();
         print_menu();
         scanf("%d", &choice);
         
@@ -606,12 +8086,143 @@ int main() {
             case 5:
                 print_graph();
                 break;
-            case 6:
+            case 6: {
+                double began = trace_begin();
                 dynamic_reschedule();
+                trace_end(began, TRACE_RESCHEDULE, 0, 0, 0, 0, NULL);
                 break;
+            }
             case 7:
                 printf("Thank you for using Optimized Dynamic Event Scheduler!\n");
                 break;
+            case 8: {
+                char name[50];
+                int capacity;
+                unsigned int features;
+                printf("Enter room name: ");
+                scanf(" %[^\n]", name);
+                printf("Enter capacity: ");
+                scanf("%d", &capacity);
+                printf("Enter features (1=projector 2=lab benches 4=video conf 8=whiteboard, sum them): ");
+                scanf("%u", &features);
+                add_room(name, capacity, features);
+                break;
+            }
+            case 9: {
+                int event_id, attendees;
+                unsigned int features;
+                printf("Enter event ID: ");
+                scanf("%d", &event_id);
+                printf("Enter expected attendees: ");
+                scanf("%d", &attendees);
+                printf("Enter required features (1=projector 2=lab benches 4=video conf 8=whiteboard, sum them): ");
+                scanf("%u", &features);
+                set_event_requirements(event_id, attendees, features);
+                break;
+            }
+            case 10:
+                print_room_assignment();
+                break;
+            case 11:
+                assign_rooms_full();
+                publish_snapshot();
+                print_room_assignment();
+                break;
+            case 12:
+                select_strategy();
+                break;
+            case 13:
+                force_algorithms();
+                break;
+            case 14:
+                printf("Current budget: %.1f ms (0 = unlimited)\n", reschedule_budget_ms);
+                printf("Enter latency budget in milliseconds: ");
+                scanf("%lf", &reschedule_budget_ms);
+                break;
+            case 15: {
+                int duration;
+                printf("Enter duration in minutes: ");
+                scanf("%d", &duration);
+                print_free_slots(duration);
+                break;
+            }
+            case 16: {
+                char name[50];
+                int event_id, start_hour, start_minute, duration, priority;
+                
+                printf("Enter event ID to update: ");
+                scanf("%d", &event_id);
+                printf("Enter new name: ");
+                scanf(" %[^\n]", name);
+                printf("Enter new start time (hour minute): ");
+                scanf("%d %d", &start_hour, &start_minute);
+                printf("Enter new duration in minutes: ");
+                scanf("%d", &duration);
+                printf("Enter new priority (1-5, 5=highest): ");
+                scanf("%d", &priority);
+                
+                update_event(event_id, name, start_hour, start_minute, duration, priority);
+                break;
+            }
+            case 17: {
+                int hour, minute;
+                printf("Expire events that ended by (hour minute): ");
+                scanf("%d %d", &hour, &minute);
+                if (expire_events(hour * 60 + minute) == 0) printf("No events have ended by then.\n");
+                break;
+            }
+            case 18: {
+                char path[256], date[16];
+                IcsImportStats stats;
+                
+                printf("Enter .ics file path: ");
+                scanf(" %255[^\n]", path);
+                printf("Import only events on date (YYYYMMDD, 0 = every event): ");
+                scanf("%15s", date);
+                double began = now_ms();
+                if (!import_ics(path, parse_ics_day_argument(date), &stats)) {
+                    printf("Cannot open %s.\n", path);
+                    break;
+                }
+                print_ics_import(path, &stats, now_ms() - began);
+                break;
+            }
+            case 19: {
+                char path[256], date[16];
+                
+                printf("Enter .ics file path: ");
+                scanf(" %255[^\n]", path);
+                printf("Date to place the events on (YYYYMMDD, 0 = today): ");
+                scanf("%15s", date);
+                int day = parse_ics_day_argument(date);
+                int written = export_ics(path, day != ICS_NO_DAY ? day : today_day());
+                if (written < 0) {
+                    printf("Cannot create %s.\n", path);
+                } else {
+                    printf("Exported %d events to %s.\n", written, path);
+                }
+                break;
+            }
+            case 20: {
+                char path[256], date[16];
+                BrowserImportStats stats;
+                long long error_offset;
+                
+                printf("Enter .json file path: ");
+                scanf(" %255[^\n]", path);
+                printf("Import only events on date (YYYYMMDD, 0 = every event): ");
+                scanf("%15s", date);
+                double began = now_ms();
+                if (!import_browser_storage(path, parse_ics_day_argument(date), &stats, &error_offset)) {
+                    if (error_offset < 0) {
+                        printf("Cannot open %s.\n", path);
+                        break;
+                    }
+                    printf("Malformed JSON in %s near byte %lld.\n", path, error_offset);
+                }
+                print_browser_import(path, &stats, now_ms() - began);
+                break;
+            }
             default:
                 printf("Invalid choice. Please try again.\n");
         }
@@ -0,0 +1,320 @@
+// Load generator for the scheduler's RPC socket.
+//
+//   gcc rpc_bench.c sched_client.c -o rpc_bench -pthread
+//   ./scheduler --serve &
+//   ./rpc_bench [socket] [connections] [requests per connection] [pipeline depth] [write %] [bulk connections]
+//
+// A setup connection first adds SEED_EVENTS events so lookups have
+// something to find. Each connection then keeps up to `depth` requests in
+// flight. It sends a mix of lookups and free-slot queries, plus adds and
+// removes of its own events (the write share). Latency is measured from
+// send to the matching response, and percentiles cover all connections.
+//
+// Bulk connections flag their writes SCHED_FLAG_BULK and churn adds and
+// removes as fast as the server admits them, backing off for the
+// retry-after of every OVERLOADED response. They run until the measured
+// connections finish and are reported separately.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "sched_client.h"
+
+#define MAX_DEPTH 1024
+#define MAX_CONNECTIONS 256
+#define SEED_EVENTS 500
+#define BULK_DEPTH 256
+#define BULK_OWN_EVENTS 256
+
+typedef struct {
+    const char* path;
+    int requests;
+    int depth;
+    int write_percent;
+    unsigned long long seed;
+    int first_id;              // Ids of the seeded events, the lookup range
+    int last_id;
+    double* latencies_us;      // One per request
+    long long errors;
+    long long not_found;
+    long long busy;
+} LoadJob;
+
+typedef struct {
+    const char* path;
+    unsigned long long seed;
+    atomic_bool* stop;
+    atomic_llong applied;      // Read by main while the job runs
+    long long overloaded;
+    long long errors;
+} BulkJob;
+
+static double now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static unsigned int next_random(unsigned long long* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return (unsigned int)((*state * 2685821657736338717ULL) >> 32);
+}
+
+static void* load_main(void* arg) {
+    LoadJob* job = (LoadJob*)arg;
+    SchedClient* client = sched_connect(job->path);
+    double sent_at[MAX_DEPTH];
+    int own_ids[64];
+    int own_count = 0;
+    int sent = 0, received = 0;
+    unsigned long long state = job->seed;
+
+    if (client == NULL) {
+        job->errors = job->requests;
+        return NULL;
+    }
+
+    while (received < job->requests) {
+        // Keep the pipeline full
+        while (sent < job->requests && sent - received < job->depth) {
+            unsigned int roll = next_random(&state) % 100;
+            if (roll < (unsigned int)job->write_percent) {
+                if (own_count > 0 && (own_count == 64 || roll % 2 == 1)) {
+                    sched_queue_remove(client, own_ids[--own_count]);
+                } else {
+                    int duration = 30 + (int)(next_random(&state) % 60);
+                    int start = (int)(next_random(&state) % (unsigned int)(24 * 60 - duration));
+                    sched_queue_add(client, "load", start, duration, 1 + (int)(roll % 5));
+                }
+            } else if (roll % 10 == 0) {
+                sched_queue_free_slots(client, 30 + 30 * (int)(roll % 3));
+            } else {
+                sched_queue_lookup(client, job->first_id + (int)(next_random(&state) % (unsigned int)(job->last_id - job->first_id + 1)));
+            }
+            sent_at[sent % job->depth] = now_us();
+            sent++;
+        }
+
+        SchedResponse response;
+        if (sched_receive(client, &response) < 0) {
+            job->errors += job->requests - received;
+            break;
+        }
+        job->latencies_us[received] = now_us() - sent_at[received % job->depth];
+        received++;
+
+        if (response.header.status == SCHED_STATUS_NOT_FOUND) job->not_found++;
+        else if (response.header.status == SCHED_STATUS_BUSY) job->busy++;
+        else if (response.header.status != SCHED_STATUS_OK) job->errors++;
+
+        SchedMutationResponse mutation;
+        if (response.header.op == SCHED_OP_ADD && response.header.status == SCHED_STATUS_OK &&
+            sched_response_mutation(&response, &mutation) == 0 && own_count < 64) {
+            own_ids[own_count++] = mutation.event_id;
+        }
+    }
+
+    sched_close(client);
+    return NULL;
+}
+
+static void* bulk_main(void* arg) {
+    BulkJob* job = (BulkJob*)arg;
+    SchedClient* client = sched_connect(job->path);
+    int own_ids[BULK_OWN_EVENTS];
+    int in_flight[BULK_DEPTH];   // Id removed by each outstanding request, 0 for adds
+    int own_count = 0, adds_in_flight = 0;
+    long long sent = 0, received = 0;
+    double resume_at = 0;
+    unsigned long long state = job->seed;
+
+    if (client == NULL) {
+        job->errors++;
+        return NULL;
+    }
+    sched_set_bulk(client, 1);
+
+    while (received < sent || !atomic_load(job->stop)) {
+        if (!atomic_load(job->stop) && now_us() >= resume_at) {
+            while (sent - received < BULK_DEPTH) {
+                // Keep at most BULK_OWN_EVENTS events alive, counting adds in flight
+                bool full = own_count + adds_in_flight >= BULK_OWN_EVENTS;
+                in_flight[sent % BULK_DEPTH] = 0;
+                if (full && own_count == 0) break;
+                if (full || (own_count > BULK_OWN_EVENTS / 2 && next_random(&state) % 2)) {
+                    in_flight[sent % BULK_DEPTH] = own_ids[--own_count];
+                    sched_queue_remove(client, in_flight[sent % BULK_DEPTH]);
+                } else {
+                    adds_in_flight++;
+                    int duration = 15 + (int)(next_random(&state) % 90);
+                    int start = (int)(next_random(&state) % (unsigned int)(24 * 60 - duration));
+                    sched_queue_add(client, "bulk", start, duration, 1 + (int)(next_random(&state) % 5));
+                }
+                sent++;
+            }
+        }
+        if (received == sent) {
+            usleep(200);
+            continue;
+        }
+
+        SchedResponse response;
+        if (sched_receive(client, &response) < 0) {
+            job->errors++;
+            break;
+        }
+        int removed_id = in_flight[received % BULK_DEPTH];
+        if (removed_id == 0) adds_in_flight--;
+        received++;
+
+        SchedRetryAfter retry;
+        SchedMutationResponse mutation;
+        if (sched_response_retry_after(&response, &retry) == 0) {
+            job->overloaded++;
+            resume_at = now_us() + retry.retry_after_ms * 1000.0;
+            if (removed_id > 0) own_ids[own_count++] = removed_id;  // Not applied
+        } else if (response.header.status == SCHED_STATUS_OK) {
+            atomic_fetch_add(&job->applied, 1);
+            if (response.header.op == SCHED_OP_ADD && sched_response_mutation(&response, &mutation) == 0) {
+                own_ids[own_count++] = mutation.event_id;
+            }
+        } else if (response.header.status != SCHED_STATUS_NOT_FOUND) {
+            job->errors++;
+        }
+    }
+
+    sched_close(client);
+    return NULL;
+}
+
+// Adds SEED_EVENTS events in one pipelined burst and reports their id range
+static int seed_events(const char* path, int* first_id, int* last_id) {
+    SchedClient* client = sched_connect(path);
+    unsigned long long state = 0x243F6A8885A308D3ULL;
+    if (client == NULL) return -1;
+
+    for (int i = 0; i < SEED_EVENTS; i++) {
+        int duration = 15 + (int)(next_random(&state) % 90);
+        int start = (int)(next_random(&state) % (unsigned int)(24 * 60 - duration));
+        sched_queue_add(client, "seed", start, duration, 1 + i % 5);
+    }
+
+    *first_id = INT_MAX;
+    *last_id = 0;
+    for (int i = 0; i < SEED_EVENTS; i++) {
+        SchedResponse response;
+        SchedMutationResponse mutation;
+        if (sched_receive(client, &response) < 0) {
+            sched_close(client);
+            return -1;
+        }
+        if (response.header.status == SCHED_STATUS_OK && sched_response_mutation(&response, &mutation) == 0) {
+            if (mutation.event_id < *first_id) *first_id = mutation.event_id;
+            if (mutation.event_id > *last_id) *last_id = mutation.event_id;
+        }
+    }
+    sched_close(client);
+    if (*last_id == 0) *first_id = *last_id = 1;
+    return 0;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char* argv[]) {
+    const char* path = argc > 1 ? argv[1] : SCHED_RPC_DEFAULT_PATH;
+    int connections = argc > 2 ? atoi(argv[2]) : 4;
+    int requests = argc > 3 ? atoi(argv[3]) : 20000;
+    int depth = argc > 4 ? atoi(argv[4]) : 16;
+    int write_percent = argc > 5 ? atoi(argv[5]) : 10;
+    int bulk_connections = argc > 6 ? atoi(argv[6]) : 0;
+    pthread_t threads[MAX_CONNECTIONS], bulk_threads[MAX_CONNECTIONS];
+    LoadJob jobs[MAX_CONNECTIONS];
+    BulkJob bulk_jobs[MAX_CONNECTIONS];
+    atomic_bool stop_bulk = false;
+
+    if (connections < 1) connections = 1;
+    if (connections > MAX_CONNECTIONS) connections = MAX_CONNECTIONS;
+    if (requests < 1) requests = 1;
+    if (depth < 1) depth = 1;
+    if (depth > MAX_DEPTH) depth = MAX_DEPTH;
+    if (bulk_connections < 0) bulk_connections = 0;
+    if (bulk_connections > MAX_CONNECTIONS) bulk_connections = MAX_CONNECTIONS;
+
+    int first_id, last_id;
+    if (seed_events(path, &first_id, &last_id) < 0) {
+        perror(path);
+        return 1;
+    }
+
+    for (int b = 0; b < bulk_connections; b++) {
+        memset(&bulk_jobs[b], 0, sizeof(bulk_jobs[b]));
+        bulk_jobs[b].path = path;
+        bulk_jobs[b].seed = 0xD1B54A32D192ED03ULL * (unsigned long long)(b + 1);
+        bulk_jobs[b].stop = &stop_bulk;
+        pthread_create(&bulk_threads[b], NULL, bulk_main, &bulk_jobs[b]);
+    }
+    if (bulk_connections > 0) usleep(200000);  // Let the bulk load build up first
+
+    double* latencies = (double*)malloc((size_t)connections * (size_t)requests * sizeof(double));
+    double start = now_us();
+    long long bulk_applied_before = 0;
+    for (int b = 0; b < bulk_connections; b++) bulk_applied_before += atomic_load(&bulk_jobs[b].applied);
+    for (int c = 0; c < connections; c++) {
+        memset(&jobs[c], 0, sizeof(jobs[c]));
+        jobs[c].path = path;
+        jobs[c].requests = requests;
+        jobs[c].depth = depth;
+        jobs[c].write_percent = write_percent;
+        jobs[c].seed = 0x9E3779B97F4A7C15ULL * (unsigned long long)(c + 1);
+        jobs[c].first_id = first_id;
+        jobs[c].last_id = last_id;
+        jobs[c].latencies_us = latencies + (size_t)c * (size_t)requests;
+        pthread_create(&threads[c], NULL, load_main, &jobs[c]);
+    }
+
+    long long errors = 0, not_found = 0, busy = 0;
+    for (int c = 0; c < connections; c++) {
+        pthread_join(threads[c], NULL);
+        errors += jobs[c].errors;
+        not_found += jobs[c].not_found;
+        busy += jobs[c].busy;
+    }
+    double elapsed_s = (now_us() - start) / 1e6;
+
+    long long bulk_applied = -bulk_applied_before, bulk_overloaded = 0;
+    atomic_store(&stop_bulk, true);
+    for (int b = 0; b < bulk_connections; b++) {
+        pthread_join(bulk_threads[b], NULL);
+        bulk_applied += atomic_load(&bulk_jobs[b].applied);
+        bulk_overloaded += bulk_jobs[b].overloaded;
+        errors += bulk_jobs[b].errors;
+    }
+
+    long long total = (long long)connections * requests;
+    qsort(latencies, (size_t)total, sizeof(double), compare_doubles);
+    printf("=== RPC LOAD (%d connections x %d requests, depth %d, %d%% writes) ===\n",
+           connections, requests, depth, write_percent);
+    printf("Throughput:   %.0f requests/s\n", total / elapsed_s);
+    printf("Latency (us): p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+           latencies[total / 2], latencies[total * 90 / 100], latencies[total * 99 / 100],
+           latencies[total * 999 / 1000], latencies[total - 1]);
+    printf("Not found:    %lld   Busy: %lld   Errors: %lld\n", not_found, busy, errors);
+    if (bulk_connections > 0) {
+        printf("Bulk lane:    %d connections, %.0f writes/s applied, %lld overloaded responses\n",
+               bulk_connections, bulk_applied / elapsed_s, bulk_overloaded);
+    }
+    printf("============================================================\n");
+
+    free(latencies);
+    return errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,281 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "sched_client.h"
+
+struct SchedClient {
+    int fd;
+    uint32_t next_tag;
+    uint16_t flags;             // Added to every queued request
+    unsigned char* output;      // Queued request frames
+    size_t output_len;
+    size_t output_cap;
+    unsigned char* input;       // Received bytes, frames parsed from the front
+    size_t input_len;
+    size_t input_cap;
+    size_t consumed;            // Bytes of the frame handed out last, dropped on the next receive
+};
+
+SchedClient* sched_connect(const char* path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return NULL;
+    }
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return NULL;
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return NULL;
+    }
+
+    SchedClient* client = (SchedClient*)calloc(1, sizeof(SchedClient));
+    client->fd = fd;
+    client->next_tag = 1;
+    return client;
+}
+
+void sched_close(SchedClient* client) {
+    if (client == NULL) return;
+    close(client->fd);
+    free(client->output);
+    free(client->input);
+    free(client);
+}
+
+static uint32_t queue_frame(SchedClient* client, uint8_t op, const void* payload, size_t payload_len) {
+    size_t frame_len = sizeof(SchedFrameHeader) + payload_len;
+    if (client->output_len + frame_len > client->output_cap) {
+        size_t cap = client->output_cap > 0 ? client->output_cap : 4096;
+        while (cap < client->output_len + frame_len) cap *= 2;
+        client->output = (unsigned char*)realloc(client->output, cap);
+        client->output_cap = cap;
+    }
+
+    SchedFrameHeader header;
+    header.length = (uint32_t)frame_len;
+    header.tag = client->next_tag++;
+    header.op = op;
+    header.status = 0;
+    header.flags = client->flags;
+    memcpy(client->output + client->output_len, &header, sizeof(header));
+    memcpy(client->output + client->output_len + sizeof(header), payload, payload_len);
+    client->output_len += frame_len;
+    return header.tag;
+}
+
+static void fill_add(SchedAddRequest* request, const char* name, int start_minute, int duration_minutes,
+                     int priority) {
+    memset(request, 0, sizeof(*request));
+    request->start_minute = start_minute;
+    request->duration_minutes = duration_minutes;
+    request->priority = priority;
+    strncpy(request->name, name, SCHED_RPC_NAME_LEN - 1);
+}
+
+static uint32_t queue_add(SchedClient* client, uint8_t op, const char* name, int start_minute,
+                          int duration_minutes, int priority) {
+    SchedAddRequest request;
+    fill_add(&request, name, start_minute, duration_minutes, priority);
+    return queue_frame(client, op, &request, sizeof(request));
+}
+
+uint32_t sched_queue_add(SchedClient* client, const char* name, int start_minute, int duration_minutes, int priority) {
+    return queue_add(client, SCHED_OP_ADD, name, start_minute, duration_minutes, priority);
+}
+
+uint32_t sched_queue_try_add(SchedClient* client, const char* name, int start_minute, int duration_minutes, int priority) {
+    return queue_add(client, SCHED_OP_TRY_ADD, name, start_minute, duration_minutes, priority);
+}
+
+uint32_t sched_queue_remove(SchedClient* client, int event_id) {
+    SchedIdRequest request = {event_id};
+    return queue_frame(client, SCHED_OP_REMOVE, &request, sizeof(request));
+}
+
+uint32_t sched_queue_update(SchedClient* client, int event_id, const char* name, int start_minute,
+                            int duration_minutes, int priority) {
+    SchedUpdateRequest request;
+    request.event_id = event_id;
+    fill_add(&request.event, name, start_minute, duration_minutes, priority);
+    return queue_frame(client, SCHED_OP_UPDATE, &request, sizeof(request));
+}
+
+uint32_t sched_queue_lookup(SchedClient* client, int event_id) {
+    SchedIdRequest request = {event_id};
+    return queue_frame(client, SCHED_OP_LOOKUP, &request, sizeof(request));
+}
+
+uint32_t sched_queue_free_slots(SchedClient* client, int duration_minutes) {
+    SchedSlotsRequest request = {duration_minutes};
+    return queue_frame(client, SCHED_OP_FREE_SLOTS, &request, sizeof(request));
+}
+
+uint32_t sched_queue_delta(SchedClient* client, uint64_t since_version) {
+    SchedDeltaRequest request = {since_version};
+    return queue_frame(client, SCHED_OP_DELTA, &request, sizeof(request));
+}
+
+void sched_set_bulk(SchedClient* client, int bulk) {
+    if (bulk) client->flags |= SCHED_FLAG_BULK;
+    else client->flags &= (uint16_t)~SCHED_FLAG_BULK;
+}
+
+int sched_flush(SchedClient* client) {
+    size_t sent = 0;
+    while (sent < client->output_len) {
+        ssize_t n = send(client->fd, client->output + sent, client->output_len - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        sent += (size_t)n;
+    }
+    client->output_len = 0;
+    return 0;
+}
+
+int sched_receive(SchedClient* client, SchedResponse* response) {
+    if (client->output_len > 0 && sched_flush(client) < 0) return -1;
+
+    // Drop the frame returned last time
+    memmove(client->input, client->input + client->consumed, client->input_len - client->consumed);
+    client->input_len -= client->consumed;
+    client->consumed = 0;
+
+    for (;;) {
+        if (client->input_len >= sizeof(SchedFrameHeader)) {
+            memcpy(&response->header, client->input, sizeof(SchedFrameHeader));
+            if (response->header.length < sizeof(SchedFrameHeader) ||
+                response->header.length > SCHED_RPC_MAX_RESPONSE) {
+                errno = EPROTO;
+                return -1;
+            }
+            if (client->input_len >= response->header.length) {
+                response->payload = client->input + sizeof(SchedFrameHeader);
+                response->payload_len = response->header.length - sizeof(SchedFrameHeader);
+                client->consumed = response->header.length;
+                return 0;
+            }
+        }
+
+        if (client->input_cap - client->input_len < 65536) {
+            client->input_cap = client->input_cap > 0 ? client->input_cap * 2 : 65536;
+            client->input = (unsigned char*)realloc(client->input, client->input_cap);
+        }
+        ssize_t n = recv(client->fd, client->input + client->input_len, client->input_cap - client->input_len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        client->input_len += (size_t)n;
+    }
+}
+
+int sched_response_mutation(const SchedResponse* response, SchedMutationResponse* out) {
+    if (response->payload_len < sizeof(*out)) return -1;
+    memcpy(out, response->payload, sizeof(*out));
+    return 0;
+}
+
+int sched_response_retry_after(const SchedResponse* response, SchedRetryAfter* out) {
+    if (response->header.status != SCHED_STATUS_OVERLOADED || response->payload_len < sizeof(*out)) return -1;
+    memcpy(out, response->payload, sizeof(*out));
+    return 0;
+}
+
+int sched_response_list(const SchedResponse* response, SchedListHeader* out) {
+    if (response->payload_len < sizeof(*out)) return -1;
+    memcpy(out, response->payload, sizeof(*out));
+    return 0;
+}
+
+int sched_response_record(const SchedResponse* response, int index, SchedEventRecord* out) {
+    size_t offset = sizeof(SchedListHeader) + (size_t)index * sizeof(SchedEventRecord);
+    if (index < 0 || response->payload_len < offset + sizeof(*out)) return -1;
+    memcpy(out, response->payload + offset, sizeof(*out));
+    return 0;
+}
+
+int sched_response_slot(const SchedResponse* response, int index, int* start_minute) {
+    size_t offset = sizeof(SchedListHeader) + (size_t)index * sizeof(int32_t);
+    int32_t start;
+    if (index < 0 || response->payload_len < offset + sizeof(start)) return -1;
+    memcpy(&start, response->payload + offset, sizeof(start));
+    *start_minute = start;
+    return 0;
+}
+
+static int call_mutation(SchedClient* client, SchedMutationResponse* out) {
+    SchedResponse response;
+    if (sched_receive(client, &response) < 0) return -1;
+    if (out != NULL && sched_response_mutation(&response, out) < 0) memset(out, 0, sizeof(*out));
+    return response.header.status;
+}
+
+int sched_add(SchedClient* client, const char* name, int start_minute, int duration_minutes, int priority,
+              SchedMutationResponse* out) {
+    sched_queue_add(client, name, start_minute, duration_minutes, priority);
+    return call_mutation(client, out);
+}
+
+int sched_try_add(SchedClient* client, const char* name, int start_minute, int duration_minutes, int priority,
+                  SchedMutationResponse* out) {
+    sched_queue_try_add(client, name, start_minute, duration_minutes, priority);
+    return call_mutation(client, out);
+}
+
+int sched_remove(SchedClient* client, int event_id, SchedMutationResponse* out) {
+    sched_queue_remove(client, event_id);
+    return call_mutation(client, out);
+}
+
+int sched_update(SchedClient* client, int event_id, const char* name, int start_minute, int duration_minutes,
+                 int priority, SchedMutationResponse* out) {
+    sched_queue_update(client, event_id, name, start_minute, duration_minutes, priority);
+    return call_mutation(client, out);
+}
+
+int sched_lookup(SchedClient* client, int event_id, SchedEventRecord* out, uint64_t* version) {
+    SchedResponse response;
+    SchedListHeader list;
+
+    sched_queue_lookup(client, event_id);
+    if (sched_receive(client, &response) < 0) return -1;
+    if (sched_response_list(&response, &list) == 0) {
+        if (version != NULL) *version = list.version;
+        if (out != NULL && list.count > 0) sched_response_record(&response, 0, out);
+    }
+    return response.header.status;
+}
+
+int sched_free_slots(SchedClient* client, int duration_minutes, int starts[], int max_starts, int* count,
+                     uint64_t* version) {
+    SchedResponse response;
+    SchedListHeader list = {0, 0, 0};
+
+    sched_queue_free_slots(client, duration_minutes);
+    if (sched_receive(client, &response) < 0) return -1;
+    sched_response_list(&response, &list);
+
+    int written = 0;
+    for (int k = 0; k < list.count && written < max_starts; k++) {
+        if (sched_response_slot(&response, k, &starts[written]) == 0) written++;
+    }
+    if (count != NULL) *count = written;
+    if (version != NULL) *version = list.version;
+    return response.header.status;
+}
+
+int sched_delta(SchedClient* client, uint64_t since_version, SchedResponse* response) {
+    sched_queue_delta(client, since_version);
+    if (sched_receive(client, response) < 0) return -1;
+    return response->header.status;
+}
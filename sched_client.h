@@ -0,0 +1,75 @@
+// Client library for the scheduler's local RPC socket (see sched_protocol.h).
+//
+// Two ways to use it:
+//  - Blocking calls (sched_add(), sched_lookup(), ...) send one request and
+//    wait for its response. Do not mix them with queued requests that are
+//    still outstanding.
+//  - Pipelined: queue any number of requests with sched_queue_*(), then
+//    read the responses in order with sched_receive(). Each queue call
+//    returns the tag its response will carry.
+//
+// Build: gcc your_program.c sched_client.c
+#ifndef SCHED_CLIENT_H
+#define SCHED_CLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sched_protocol.h"
+
+typedef struct SchedClient SchedClient;
+
+// One received frame. payload points into the client and stays valid until
+// the next sched_receive() on the same client.
+typedef struct {
+    SchedFrameHeader header;
+    const unsigned char* payload;
+    size_t payload_len;
+} SchedResponse;
+
+// NULL on failure with errno set
+SchedClient* sched_connect(const char* path);
+void sched_close(SchedClient* client);
+
+uint32_t sched_queue_add(SchedClient* client, const char* name, int start_minute, int duration_minutes, int priority);
+uint32_t sched_queue_try_add(SchedClient* client, const char* name, int start_minute, int duration_minutes, int priority);
+uint32_t sched_queue_remove(SchedClient* client, int event_id);
+uint32_t sched_queue_update(SchedClient* client, int event_id, const char* name, int start_minute,
+                            int duration_minutes, int priority);
+uint32_t sched_queue_lookup(SchedClient* client, int event_id);
+uint32_t sched_queue_free_slots(SchedClient* client, int duration_minutes);
+uint32_t sched_queue_delta(SchedClient* client, uint64_t since_version);
+
+// Route this client's subsequent writes to the bulk lane (or back)
+void sched_set_bulk(SchedClient* client, int bulk);
+
+// Send everything queued so far. 0 on success, -1 on I/O error.
+int sched_flush(SchedClient* client);
+
+// Flush, then block for the next response. 0 on success, -1 on I/O error
+// or a closed connection.
+int sched_receive(SchedClient* client, SchedResponse* response);
+
+// Payload accessors; -1 if the payload is too short
+int sched_response_mutation(const SchedResponse* response, SchedMutationResponse* out);
+int sched_response_list(const SchedResponse* response, SchedListHeader* out);
+int sched_response_retry_after(const SchedResponse* response, SchedRetryAfter* out);
+int sched_response_record(const SchedResponse* response, int index, SchedEventRecord* out);
+int sched_response_slot(const SchedResponse* response, int index, int* start_minute);
+
+// Blocking calls. Each returns the SCHED_STATUS_* of the response, or -1
+// on I/O error. Output pointers may be NULL.
+int sched_add(SchedClient* client, const char* name, int start_minute, int duration_minutes, int priority,
+              SchedMutationResponse* out);
+int sched_try_add(SchedClient* client, const char* name, int start_minute, int duration_minutes, int priority,
+                  SchedMutationResponse* out);
+int sched_remove(SchedClient* client, int event_id, SchedMutationResponse* out);
+int sched_update(SchedClient* client, int event_id, const char* name, int start_minute, int duration_minutes,
+                 int priority, SchedMutationResponse* out);
+int sched_lookup(SchedClient* client, int event_id, SchedEventRecord* out, uint64_t* version);
+int sched_free_slots(SchedClient* client, int duration_minutes, int starts[], int max_starts, int* count,
+                     uint64_t* version);
+// The response stays valid until the next receive; read it with
+// sched_response_list() and sched_response_record()
+int sched_delta(SchedClient* client, uint64_t since_version, SchedResponse* response);
+
+#endif
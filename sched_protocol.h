@@ -0,0 +1,138 @@
+// Wire protocol of the scheduler's local RPC socket (./scheduler --serve).
+//
+// Transport: SOCK_STREAM Unix domain socket. Both sides are on one host,
+// so integers are sent in native byte order and structs are sent as-is.
+//
+// Every message is one frame: a SchedFrameHeader followed by an op-specific
+// payload. `length` counts the whole frame, header included. Clients may
+// pipeline any number of requests without waiting. Responses on a
+// connection come back in request order and echo the request's tag.
+//
+//   op              request payload     response payload
+//   --------------  ------------------  ------------------------------------
+//   ADD             SchedAddRequest     SchedMutationResponse
+//   REMOVE          SchedIdRequest      SchedMutationResponse
+//   LOOKUP          SchedIdRequest      SchedListHeader + 0 or 1 SchedEventRecord
+//   FREE_SLOTS      SchedSlotsRequest   SchedListHeader + count int32 start minutes
+//   TRY_ADD         SchedAddRequest     SchedMutationResponse (BUSY if the time is taken)
+//   DELTA           SchedDeltaRequest   SchedListHeader + count SchedEventRecord
+//   UPDATE          SchedUpdateRequest  SchedMutationResponse (NOT_FOUND if no such event)
+//
+// Any write may instead get OVERLOADED with a SchedRetryAfter payload.
+//
+// Writes (ADD, TRY_ADD, REMOVE, UPDATE) are admitted into one of two bounded lanes.
+// Requests flagged SCHED_FLAG_BULK go to the bulk lane, which is drained
+// only after the interactive lane. When a lane is full the write is refused
+// with OVERLOADED and a SchedRetryAfter payload instead of being queued. A
+// connection's writes are always applied in the order sent.
+//
+// Mutation responses carry the schedule version in which the change is
+// visible. LOOKUP and FREE_SLOTS read the latest published version, which
+// may not yet include writes sent just before them on the same connection;
+// compare versions to tell. DELTA returns every event that changed after since_version,
+// with `removed` set for deleted ones. If the server no longer remembers
+// that far back, `full` is set and the records are the whole schedule.
+#ifndef SCHED_PROTOCOL_H
+#define SCHED_PROTOCOL_H
+
+#include <stdint.h>
+
+#define SCHED_RPC_DEFAULT_PATH "/tmp/scheduler.sock"
+#define SCHED_RPC_MAX_REQUEST 256         // Larger request frames close the connection
+#define SCHED_RPC_MAX_RESPONSE (1 << 20)  // Enough for a full DELTA of MAX_EVENTS records
+#define SCHED_RPC_NAME_LEN 52             // NUL-padded; the engine keeps the first 49 bytes
+
+enum {
+    SCHED_OP_ADD = 1,
+    SCHED_OP_REMOVE = 2,
+    SCHED_OP_LOOKUP = 3,
+    SCHED_OP_FREE_SLOTS = 4,
+    SCHED_OP_TRY_ADD = 5,
+    SCHED_OP_DELTA = 6,
+    SCHED_OP_UPDATE = 7
+};
+
+enum {
+    SCHED_STATUS_OK = 0,
+    SCHED_STATUS_NOT_FOUND = 1,   // No event with that id
+    SCHED_STATUS_BUSY = 2,        // TRY_ADD: the requested time overlaps the schedule
+    SCHED_STATUS_INVALID = 3,     // Malformed payload or out-of-range time
+    SCHED_STATUS_FULL = 4,        // The event store is at capacity
+    SCHED_STATUS_BAD_OP = 5,
+    SCHED_STATUS_OVERLOADED = 6   // Write lane full: not applied, retry later
+};
+
+enum {
+    SCHED_FLAG_BULK = 1           // Request flag: admit this write into the bulk lane
+};
+
+typedef struct {
+    uint32_t length;     // Whole frame in bytes, header included
+    uint32_t tag;        // Chosen by the client, echoed in the response
+    uint8_t op;
+    uint8_t status;      // Responses only
+    uint16_t flags;      // Requests only, SCHED_FLAG_*
+} SchedFrameHeader;
+
+typedef struct {
+    int32_t start_minute;      // Minutes from midnight
+    int32_t duration_minutes;
+    int32_t priority;          // 1-5, 5 = highest
+    char name[SCHED_RPC_NAME_LEN];
+} SchedAddRequest;
+
+typedef struct {
+    int32_t event_id;
+} SchedIdRequest;
+
+// Replaces the event's name, time and priority; the id stays the same
+typedef struct {
+    int32_t event_id;
+    SchedAddRequest event;
+} SchedUpdateRequest;
+
+typedef struct {
+    int32_t duration_minutes;
+} SchedSlotsRequest;
+
+typedef struct {
+    uint64_t since_version;    // 0 = everything
+} SchedDeltaRequest;
+
+typedef struct {
+    uint64_t version;          // Schedule version that contains the change
+    int32_t event_id;          // New id for ADD/TRY_ADD, echoed for REMOVE/UPDATE
+    int32_t scheduled;         // ADD/TRY_ADD/UPDATE: 1 if the event got a place
+} SchedMutationResponse;
+
+typedef struct {
+    uint32_t retry_after_ms;   // Estimated time until the lane has room
+    uint32_t queued;           // Writes waiting in the lane
+} SchedRetryAfter;
+
+typedef struct {
+    uint64_t version;          // Schedule version the records describe
+    int32_t count;
+    int32_t full;              // DELTA: 1 if this is a full resync
+} SchedListHeader;
+
+typedef struct {
+    int32_t event_id;
+    int32_t start_minute;
+    int32_t end_minute;
+    int32_t priority;
+    int32_t color;
+    int32_t room;              // Index of the assigned room, -1 = none
+    int32_t scheduled;
+    int32_t removed;           // DELTA only: the event no longer exists
+    char name[SCHED_RPC_NAME_LEN];
+} SchedEventRecord;
+
+_Static_assert(sizeof(SchedFrameHeader) == 12, "frame header layout");
+_Static_assert(sizeof(SchedAddRequest) == 64, "add request layout");
+_Static_assert(sizeof(SchedUpdateRequest) == 68, "update request layout");
+_Static_assert(sizeof(SchedMutationResponse) == 16, "mutation response layout");
+_Static_assert(sizeof(SchedListHeader) == 16, "list header layout");
+_Static_assert(sizeof(SchedEventRecord) == 84, "event record layout");
+
+#endif
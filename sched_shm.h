@@ -0,0 +1,103 @@
+// Shared-memory layout of the published schedule (./scheduler --shm [name]).
+//
+// The engine creates a POSIX shared-memory object (default
+// SCHED_SHM_DEFAULT_NAME) and rewrites it after every committed change.
+// Readers on the same host map it read-only and read records in place: no
+// syscalls and no copies after the initial mmap.
+//
+// Layout: one SchedShmRegion, a header followed by two buffers. The writer
+// fills the buffer that is not active, then flips `active`. Each buffer has
+// its own sequence counter, which is odd while the writer is filling it.
+// A reader only has to retry if it is still reading a buffer when the
+// writer comes back to it two publishes later:
+//
+//   uint32_t sequence;
+//   const SchedShmBuffer* buffer;
+//   do {
+//       buffer = sched_shm_read_begin(region, &sequence);
+//       ... read buffer->count, buffer->events[0 .. count) ...
+//   } while (!sched_shm_read_valid(buffer, sequence));
+//
+// Values read inside the loop must not be acted on until it exits.
+// Integers are native byte order. Records are in schedule order (by start
+// time) and use the same SchedEventRecord as the RPC protocol.
+#ifndef SCHED_SHM_H
+#define SCHED_SHM_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "sched_protocol.h"
+
+#define SCHED_SHM_DEFAULT_NAME "/scheduler-schedule"
+#define SCHED_SHM_MAGIC 0x53434844u       // "SCHD"
+#define SCHED_SHM_LAYOUT_VERSION 1
+#define SCHED_SHM_CAPACITY 5000           // Records per buffer (the engine's MAX_EVENTS)
+
+typedef struct {
+    _Atomic uint32_t sequence;   // Odd while the writer fills this buffer
+    uint32_t count;              // Valid records in events[]
+    uint64_t version;            // Schedule version these records describe
+    SchedEventRecord events[SCHED_SHM_CAPACITY];
+} SchedShmBuffer;
+
+typedef struct {
+    uint32_t magic;              // SCHED_SHM_MAGIC once the writer has initialised the region
+    uint32_t layout_version;     // SCHED_SHM_LAYOUT_VERSION
+    uint32_t capacity;           // SCHED_SHM_CAPACITY
+    uint32_t writer_pid;
+    _Atomic uint32_t active;     // Index of the buffer readers should use
+    uint32_t reserved;
+    _Atomic uint64_t version;    // Version of the active buffer, for cheap change polling
+    uint8_t padding[32];         // Keep the buffers on their own cache lines
+    SchedShmBuffer buffers[2];
+} SchedShmRegion;
+
+_Static_assert(offsetof(SchedShmRegion, buffers) == 64, "shm header layout");
+_Static_assert(offsetof(SchedShmBuffer, events) == 16, "shm buffer layout");
+
+// Start a read: returns the active buffer and its (even) sequence number
+static inline const SchedShmBuffer* sched_shm_read_begin(const SchedShmRegion* region, uint32_t* sequence) {
+    for (;;) {
+        uint32_t index = atomic_load_explicit((_Atomic uint32_t*)&region->active, memory_order_acquire) & 1;
+        const SchedShmBuffer* buffer = &region->buffers[index];
+        uint32_t seq = atomic_load_explicit((_Atomic uint32_t*)&buffer->sequence, memory_order_acquire);
+        if ((seq & 1) == 0) {
+            *sequence = seq;
+            return buffer;
+        }
+    }
+}
+
+// True if nothing read from the buffer since sched_shm_read_begin() was torn
+static inline int sched_shm_read_valid(const SchedShmBuffer* buffer, uint32_t sequence) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit((_Atomic uint32_t*)&buffer->sequence, memory_order_relaxed) == sequence;
+}
+
+// Map a published schedule read-only. NULL if it does not exist yet or
+// was written with a different layout.
+static inline const SchedShmRegion* sched_shm_open(const char* name) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return NULL;
+    void* memory = mmap(NULL, sizeof(SchedShmRegion), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) return NULL;
+
+    const SchedShmRegion* region = (const SchedShmRegion*)memory;
+    if (region->magic != SCHED_SHM_MAGIC || region->layout_version != SCHED_SHM_LAYOUT_VERSION ||
+        region->capacity != SCHED_SHM_CAPACITY) {
+        munmap(memory, sizeof(SchedShmRegion));
+        return NULL;
+    }
+    return region;
+}
+
+static inline void sched_shm_close(const SchedShmRegion* region) {
+    if (region != NULL) munmap((void*)region, sizeof(SchedShmRegion));
+}
+
+#endif